@@ -1,7 +1,9 @@
 #ifndef BUSINESS_INTERFACE_H
 #define BUSINESS_INTERFACE_H
 
+#include "storage/cow_vector.h"
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class SatelliteHub;
@@ -14,16 +16,27 @@ struct Listing {
 
 class BusinessInterface {
 public:
+    using ListingImage = CowVector<Listing>::Image;
+
     BusinessInterface() = default;
     explicit BusinessInterface(SatelliteHub* hub);  
 
     bool createListing(const Listing& listing);
     bool updateListing(const std::string& name, int newQuantity, double newPrice);
     std::vector<Listing> getListings() const;
+    // Up to `limit` listings starting at `offset`, in creation order.
+    std::vector<Listing> getListings(size_t offset, size_t limit) const;
+    bool findListing(const std::string& name, Listing& listing) const;
+
+    // Frozen view of the listings for snapshotting; cheap to take.
+    ListingImage image() const;
+    size_t listingCount() const;
 
 private:
     SatelliteHub* m_hub = nullptr;
-    std::vector<Listing> m_listings;
+    CowVector<Listing> m_listings;
+    // First listing with each name; listings are never removed.
+    std::unordered_map<std::string, CowVector<Listing>::Position> m_byName;
 };
 
 #endif // BUSINESS_INTERFACE_H
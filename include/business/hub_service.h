@@ -0,0 +1,74 @@
+#ifndef HUB_SERVICE_H
+#define HUB_SERVICE_H
+
+#include "business/business_interface.h"
+#include "business/recipient_interface.h"
+#include "storage/market_store.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class SatelliteHub;
+
+// Thread-safe facade over the business and recipient interfaces plus the
+// satellite uplink, shared by every front end of the hub daemon.
+class HubService {
+public:
+    explicit HubService(SatelliteHub* hub = nullptr);
+
+    // Recovers the market from `directory` and journals every mutation from
+    // then on; mutations return only once durable. Once the log fails every
+    // mutation is refused; writes caught in the failed batch return false
+    // but stay visible until restart and are never snapshotted. Mutations
+    // block on fdatasync, so keep them off event-loop threads. Call before
+    // serving.
+    bool enableDurability(const std::string& directory, MarketStore::Options options);
+    bool enableDurability(const std::string& directory) {
+        return enableDurability(directory, MarketStore::Options());
+    }
+
+    // Writes a snapshot of the current market without blocking writers
+    // beyond taking copy-on-write images. No-op without durability.
+    bool checkpoint();
+
+    // The rules every front end (HTTP, IPC, federation) enforces: listings
+    // need a non-negative quantity and a finite, non-negative price;
+    // preorders need a positive quantity. Mutations refuse anything else.
+    static bool isValid(const Listing& listing);
+    static bool isValid(const Preorder& preorder);
+
+    bool createListing(const Listing& listing);
+    bool updateListing(const std::string& name, int newQuantity, double newPrice);
+    std::vector<Listing> getListings() const;
+    // One page of listings plus the total count, taken under a single lock.
+    std::vector<Listing> getListings(size_t offset, size_t limit, size_t& total) const;
+    bool findListing(const std::string& name, Listing& listing) const;
+
+    bool placePreorder(const Preorder& preorder);
+    bool cancelPreorder(const std::string& itemName);
+    std::vector<Preorder> getPreorders() const;
+    std::vector<Preorder> getPreorders(size_t offset, size_t limit, size_t& total) const;
+
+    // Relays a signed transaction over the satellite link. Fails when the
+    // hub is offline.
+    bool submitTransaction(const std::string& transaction);
+    bool satelliteSend(const std::string& data);
+
+    uint64_t transactionsSubmitted() const;
+
+private:
+    bool commit(uint64_t lsn);
+
+    SatelliteHub* m_hub;
+    mutable std::mutex m_marketMutex;
+    mutable std::mutex m_uplinkMutex;
+    BusinessInterface m_business;
+    RecipientInterface m_recipient;
+    uint64_t m_transactionsSubmitted = 0;
+    // Declared last so its checkpoint thread stops before the market goes.
+    std::unique_ptr<MarketStore> m_store;
+};
+
+#endif // HUB_SERVICE_H
@@ -1,6 +1,7 @@
 #ifndef RECIPIENT_INTERFACE_H
 #define RECIPIENT_INTERFACE_H
 
+#include "storage/cow_vector.h"
 #include <string>
 #include <vector>
 
@@ -13,16 +14,25 @@ struct Preorder {
 
 class RecipientInterface {
 public:
+    using PreorderImage = CowVector<Preorder>::Image;
+
     RecipientInterface() = default;
     explicit RecipientInterface(SatelliteHub* hub); 
 
     bool placePreorder(const Preorder& preorder);
     bool cancelPreorder(const std::string& itemName);
+    bool hasPreorder(const std::string& itemName) const;
     std::vector<Preorder> getPreorders() const;
+    // Up to `limit` preorders starting at `offset`, in placement order.
+    std::vector<Preorder> getPreorders(size_t offset, size_t limit) const;
+
+    // Frozen view of the preorders for snapshotting; cheap to take.
+    PreorderImage image() const;
+    size_t preorderCount() const;
 
 private:
     SatelliteHub* m_hub = nullptr;
-    std::vector<Preorder> m_preorders;
+    CowVector<Preorder> m_preorders;
 };
 
 #endif // RECIPIENT_INTERFACE_H
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Consistent hashing with virtual nodes. Each member owns `virtualNodes`
+// points on a 64-bit ring; a key belongs to the first points clockwise from
+// its hash. Adding or removing one of N members moves only ~1/N of the keys.
+class ConsistentHashRing {
+public:
+    explicit ConsistentHashRing(unsigned virtualNodes = 128);
+
+    void addNode(uint32_t node);
+    void removeNode(uint32_t node);
+    bool contains(uint32_t node) const;
+    size_t nodeCount() const { return m_nodes.size(); }
+
+    // Up to `count` distinct members in preference order for `key`: the
+    // primary owner first, then its replicas.
+    std::vector<uint32_t> preferenceList(const std::string& key, size_t count) const;
+    uint32_t owner(const std::string& key) const;
+
+    static uint64_t hash(const std::string& key);
+
+private:
+    unsigned m_virtualNodes;
+    std::vector<uint32_t> m_nodes;
+    std::vector<std::pair<uint64_t, uint32_t>> m_points;  // sorted by position
+};
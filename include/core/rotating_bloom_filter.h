@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two-generation Bloom filter for "seen recently" checks on 64-bit ids.
+// Inserts go to the current generation and lookups consult both; rotate()
+// drops the older one, so an id is remembered for at least one full
+// generation and memory stays fixed no matter how long the node runs.
+class RotatingBloomFilter {
+public:
+    RotatingBloomFilter(size_t bitsPerGeneration, unsigned hashes);
+
+    bool contains(uint64_t id) const;
+    void insert(uint64_t id);
+
+    // Inserts `id` and reports whether it was (probably) new.
+    bool insertIfAbsent(uint64_t id);
+
+    void rotate();
+
+    // Inserts into the current generation since the last rotate().
+    size_t generationSize() const { return m_generationSize; }
+
+    // Inserts per generation at which the false-positive rate reaches ~1%.
+    size_t capacity() const;
+
+private:
+    bool test(const std::vector<uint64_t>& bits, uint64_t h1, uint64_t h2) const;
+
+    size_t m_bits;
+    unsigned m_hashes;
+    std::vector<uint64_t> m_current;
+    std::vector<uint64_t> m_previous;
+    size_t m_generationSize = 0;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Hierarchical timer wheel (Varghese & Lauck) driving key rotation, session
+// expiry, retries and heartbeat deadlines. Timers are intrusive: callers own
+// the TimerWheel::Timer storage, so scheduling never allocates and both
+// schedule() and cancel() are O(1). The wheel is single-threaded; whoever owns
+// it calls advance() from their event loop.
+class TimerWheel {
+public:
+    using Callback = void (*)(void* context);
+
+    class Timer {
+    public:
+        Timer() = default;
+        Timer(Callback callback, void* context) : m_callback(callback), m_context(context) {}
+        ~Timer() { unlink(); }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+        void setCallback(Callback callback, void* context) {
+            m_callback = callback;
+            m_context = context;
+        }
+        bool isPending() const { return m_next != nullptr; }
+        uint64_t expiry() const { return m_expiry; }
+
+    private:
+        friend class TimerWheel;
+
+        void unlink() {
+            if (m_next) {
+                m_prev->m_next = m_next;
+                m_next->m_prev = m_prev;
+                m_next = m_prev = nullptr;
+                if (m_owner) {
+                    --m_owner->m_pending;
+                    --m_owner->m_levelPending[m_level];
+                    m_owner = nullptr;
+                }
+            }
+        }
+
+        Timer* m_next = nullptr;
+        Timer* m_prev = nullptr;
+        TimerWheel* m_owner = nullptr;
+        uint64_t m_expiry = 0;
+        int m_level = 0;
+        Callback m_callback = nullptr;
+        void* m_context = nullptr;
+    };
+
+    explicit TimerWheel(uint64_t startTick = 0);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // Arms (or re-arms) a timer to fire once `delay` ticks from now. A delay of
+    // zero fires on the next advance.
+    void schedule(Timer& timer, uint64_t delay);
+    void scheduleAt(Timer& timer, uint64_t expiryTick);
+    void cancel(Timer& timer) { timer.unlink(); }
+
+    // Moves the wheel forward to `nowTick`, firing every timer whose expiry is
+    // at or before it. Returns the number of callbacks invoked.
+    size_t advanceTo(uint64_t nowTick);
+    size_t advance(uint64_t ticks) { return advanceTo(m_now + ticks); }
+
+    uint64_t now() const { return m_now; }
+    size_t pending() const { return m_pending; }
+
+private:
+    static constexpr int kRootBits = 8;
+    static constexpr int kLevelBits = 6;
+    static constexpr int kLevels = 5;  // 8 + 4 * 6 = 32 bits of tick range
+    static constexpr size_t kRootSlots = size_t(1) << kRootBits;
+    static constexpr size_t kLevelSlots = size_t(1) << kLevelBits;
+    static constexpr uint64_t kMaxSpan = (uint64_t(1) << (kRootBits + (kLevels - 1) * kLevelBits)) - 1;
+
+    // Each slot is a sentinel Timer heading a circular intrusive list.
+    using Slot = Timer;
+
+    void place(Timer& timer);
+    void cascade(int level, size_t index);
+    size_t expireSlot(Slot& slot);
+    Slot& slotFor(uint64_t expiry, int& level);
+    void skipIdleTicks(uint64_t nowTick);
+
+    Slot m_root[kRootSlots];
+    Slot m_levels[kLevels - 1][kLevelSlots];
+    uint64_t m_now;
+    size_t m_pending = 0;
+    size_t m_levelPending[kLevels] = {};  // index 0 is the root wheel
+};
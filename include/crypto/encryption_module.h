@@ -0,0 +1,36 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Authenticated symmetric encryption (ChaCha20-Poly1305, IETF variant) from
+// libsodium, used for hop-by-hop protection on the Wi-Fi mesh. Each call
+// seals or opens a whole buffer, so callers batch records to pay the
+// per-call cost once.
+class EncryptionModule {
+public:
+    static constexpr size_t kKeyBytes = 32;
+    static constexpr size_t kNonceBytes = 12;
+    static constexpr size_t kTagBytes = 16;
+
+    using Key = std::array<uint8_t, kKeyBytes>;
+    using Nonce = std::array<uint8_t, kNonceBytes>;
+
+    // Safe to call repeatedly and from several threads.
+    static bool initialize();
+
+    static Key generateKey();
+    static void randomBytes(void* out, size_t length);
+
+    // Appends ciphertext plus tag for `plaintext` to `out`. `associated` is
+    // authenticated but not encrypted. A nonce must never repeat per key.
+    static void seal(const Key& key, const Nonce& nonce, const uint8_t* associated, size_t associatedLength,
+                     const uint8_t* plaintext, size_t length, std::vector<uint8_t>& out);
+
+    // Replaces `out` with the plaintext; false if the data was tampered with
+    // or sealed under another key.
+    static bool open(const Key& key, const Nonce& nonce, const uint8_t* associated, size_t associatedLength,
+                     const uint8_t* ciphertext, size_t length, std::vector<uint8_t>& out);
+};
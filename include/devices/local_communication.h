@@ -1,6 +1,10 @@
 #pragma once
 
 #include "riif_ultrasonic.h"
+#include "core/timer_wheel.h"
+#include "ultrasonic/ultrasonic_modem.h"
+#include "ultrasonic/waveform_synthesizer.h"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -14,8 +18,35 @@ public:
     bool sendSecureData(const std::string& data);
     bool receiveSecureData(std::string& data);
 
+    // Sends `announcement` in the clear, as hub beacons are. Announcements
+    // repeat, so their PCM is synthesized once and cached.
+    bool broadcastAnnouncement(const std::string& announcement);
+    // PCM of the last transmission, as handed to the speaker.
+    const std::vector<int16_t>& lastTransmission() const;
+    const WaveformSynthesizer& synthesizer() const { return *m_synthesizer; }
+
+    // Rotates the shared key every `rotationTicks` and drops it after
+    // `sessionTimeoutTicks` without traffic, both driven by `wheel`.
+    // A zero interval disables that timer.
+    void enableKeyLifecycle(TimerWheel& wheel, uint64_t rotationTicks, uint64_t sessionTimeoutTicks);
+    bool hasSessionKey() const { return !m_sharedKey.empty(); }
+
 private:
+    static void onKeyRotation(void* context);
+    static void onSessionExpired(void* context);
+    void armKeyTimers();
+    void touchSession();
+    void configureModem();
+
     RiifUltrasonic m_ultrasonic;
+    std::unique_ptr<UltrasonicModem> m_modem;
+    std::unique_ptr<WaveformSynthesizer> m_synthesizer;
     std::vector<uint8_t> m_sharedKey;
-    std::vector<int16_t> m_lastSentData;  // Added for simulation purposes
+    WaveformSynthesizer::Pcm m_lastSentData;  // Added for simulation purposes
+
+    TimerWheel* m_wheel = nullptr;
+    TimerWheel::Timer m_rotationTimer{&LocalCommunication::onKeyRotation, this};
+    TimerWheel::Timer m_sessionTimer{&LocalCommunication::onSessionExpired, this};
+    uint64_t m_rotationTicks = 0;
+    uint64_t m_sessionTimeoutTicks = 0;
 };
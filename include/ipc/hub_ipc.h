@@ -0,0 +1,61 @@
+#pragma once
+
+#include "business/hub_service.h"
+#include "ipc/hub_ipc_protocol.h"
+#include "ipc/shm_channel.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Daemon side of the shared-memory bridge: decodes requests from the Node
+// API server and answers them from a HubService.
+class HubIpcServer {
+public:
+    // A null channel makes a pure executor for handle(); serve() then
+    // returns at once.
+    HubIpcServer(HubService& service, std::unique_ptr<ShmChannel> channel);
+
+    // Serves requests until `running` is cleared (see stop()).
+    void serve(const std::atomic<bool>& running);
+    void stop() {
+        if (m_channel) {
+            m_channel->interrupt();
+        }
+    }
+
+    // Handles one encoded request and appends the encoded response.
+    void handle(const std::vector<uint8_t>& request, std::vector<uint8_t>& response);
+
+private:
+    IpcStatus dispatch(IpcOp op, IpcReader& reader, std::vector<uint8_t>& payload);
+
+    HubService& m_service;
+    std::unique_ptr<ShmChannel> m_channel;
+};
+
+// Client side, used by the benchmark and tests. Any other client (such as a
+// Node native addon) only needs the layout in hub_ipc_protocol.h.
+class HubIpcClient {
+public:
+    explicit HubIpcClient(std::unique_ptr<ShmChannel> channel);
+
+    // Round trip; returns the response status and fills `response` with its
+    // payload. Fails with IpcStatus::Failed on timeout.
+    IpcStatus call(IpcOp op, const std::vector<uint8_t>& payload, std::vector<uint8_t>& response,
+                   int timeoutMs = 5000);
+
+    // Pipelined use: post() returns false when the request ring is full and
+    // poll() collects one response if available.
+    bool post(IpcOp op, const std::vector<uint8_t>& payload, uint32_t& requestId);
+    bool poll(IpcHeader& header, std::vector<uint8_t>& payload, int timeoutMs);
+
+    IpcStatus createListing(const Listing& listing);
+    IpcStatus placePreorder(const Preorder& preorder);
+    IpcStatus listListings(uint32_t offset, std::vector<Listing>& listings, uint32_t& total);
+
+private:
+    std::unique_ptr<ShmChannel> m_channel;
+    uint32_t m_nextRequestId = 1;
+    std::vector<uint8_t> m_message;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Fixed binary layout spoken over ShmChannel. Every message is an
+// IpcHeader followed by `payloadLength` bytes. Integers are little-endian
+// (host order on every supported target), strings are a uint16 length then
+// raw bytes, doubles are IEEE-754.
+//
+// List responses hold as many entries as fit one slot; clients page by
+// re-requesting from offset + count. An entry too large for an otherwise
+// empty page comes back with its name truncated, so paging always advances.
+//
+//   CreateListing     req: string name, int32 quantity, f64 price
+//   UpdateListing     req: string name, int32 quantity, f64 price
+//   ListListings      req: uint32 offset
+//                     rsp: uint32 total, uint32 count, count x (string, int32, f64)
+//   PlacePreorder     req: string itemName, int32 quantity
+//   CancelPreorder    req: string itemName
+//   ListPreorders     req: uint32 offset
+//                     rsp: uint32 total, uint32 count, count x (string, int32)
+//   SubmitTransaction req: raw transaction bytes (rest of payload)
+//   SatelliteSend     req: raw bytes (rest of payload)
+//   GetListing        req: string name
+//                     rsp: string name, int32 quantity, f64 price
+
+enum class IpcOp : uint16_t {
+    CreateListing = 1,
+    UpdateListing = 2,
+    ListListings = 3,
+    PlacePreorder = 4,
+    CancelPreorder = 5,
+    ListPreorders = 6,
+    SubmitTransaction = 7,
+    SatelliteSend = 8,
+    GetListing = 9,
+};
+
+enum class IpcStatus : uint16_t {
+    Ok = 0,
+    NotFound = 1,
+    BadRequest = 2,
+    TooLarge = 3,
+    Failed = 4,
+    UnknownOp = 5,
+};
+
+struct IpcHeader {
+    uint32_t requestId;
+    uint16_t op;      // IpcOp
+    uint16_t status;  // IpcStatus; zero in requests
+    uint32_t payloadLength;
+};
+static_assert(sizeof(IpcHeader) == 12, "IpcHeader layout is part of the wire format");
+
+class IpcWriter {
+public:
+    explicit IpcWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void u16(uint16_t v) { raw(&v, sizeof(v)); }
+    void u32(uint32_t v) { raw(&v, sizeof(v)); }
+    void u64(uint64_t v) { raw(&v, sizeof(v)); }
+    void i32(int32_t v) { raw(&v, sizeof(v)); }
+    void f64(double v) { raw(&v, sizeof(v)); }
+    void str(const std::string& s) {
+        uint16_t length = static_cast<uint16_t>(s.size() > 0xFFFF ? 0xFFFF : s.size());
+        u16(length);
+        raw(s.data(), length);
+    }
+    void raw(const void* data, size_t length) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        m_out.insert(m_out.end(), bytes, bytes + length);
+    }
+    size_t size() const { return m_out.size(); }
+
+private:
+    std::vector<uint8_t>& m_out;
+};
+
+class IpcReader {
+public:
+    IpcReader(const uint8_t* data, size_t length) : m_data(data), m_length(length) {}
+
+    bool u16(uint16_t& v) { return raw(&v, sizeof(v)); }
+    bool u32(uint32_t& v) { return raw(&v, sizeof(v)); }
+    bool u64(uint64_t& v) { return raw(&v, sizeof(v)); }
+    bool i32(int32_t& v) { return raw(&v, sizeof(v)); }
+    bool f64(double& v) { return raw(&v, sizeof(v)); }
+    bool str(std::string& s) {
+        uint16_t length;
+        if (!u16(length) || remaining() < length) {
+            return false;
+        }
+        s.assign(reinterpret_cast<const char*>(m_data + m_offset), length);
+        m_offset += length;
+        return true;
+    }
+    std::string rest() {
+        std::string s(reinterpret_cast<const char*>(m_data + m_offset), remaining());
+        m_offset = m_length;
+        return s;
+    }
+    bool skip(size_t length) {
+        if (remaining() < length) {
+            return false;
+        }
+        m_offset += length;
+        return true;
+    }
+    size_t remaining() const { return m_length - m_offset; }
+
+private:
+    bool raw(void* out, size_t length) {
+        if (remaining() < length) {
+            return false;
+        }
+        std::memcpy(out, m_data + m_offset, length);
+        m_offset += length;
+        return true;
+    }
+
+    const uint8_t* m_data;
+    size_t m_length;
+    size_t m_offset = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Shared-memory transport between the hub daemon and one local client (the
+// Node API server). A POSIX shm segment holds two single-producer rings of
+// fixed-size slots, one per direction. Messages are copied straight into the
+// slots; a Unix datagram socket is only used as a doorbell when the reader
+// has gone to sleep, so a busy channel makes no syscalls per message.
+
+struct ShmRingHeader {
+    uint32_t slotSize;
+    uint32_t slotCount;
+    alignas(64) std::atomic<uint64_t> head;  // written by producer
+    alignas(64) std::atomic<uint64_t> tail;  // written by consumer
+    alignas(64) std::atomic<uint32_t> consumerWaiting;
+};
+
+class ShmRing {
+public:
+    ShmRing() = default;
+    ShmRing(ShmRingHeader* header, uint8_t* slots) : m_header(header), m_slots(slots) {}
+
+    static size_t bytesFor(uint32_t slotSize, uint32_t slotCount);
+    void initialize(uint32_t slotSize, uint32_t slotCount);
+
+    // Largest message that fits in one slot.
+    size_t maxMessageSize() const { return m_header->slotSize - sizeof(uint32_t); }
+
+    bool tryPush(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length);
+    bool tryPop(std::vector<uint8_t>& out);
+    size_t depth() const;
+
+    ShmRingHeader* header() const { return m_header; }
+
+private:
+    uint8_t* slot(uint64_t index) const {
+        return m_slots + (index % m_header->slotCount) * m_header->slotSize;
+    }
+
+    ShmRingHeader* m_header = nullptr;
+    uint8_t* m_slots = nullptr;
+};
+
+class ShmChannel {
+public:
+    enum class Role { Server, Client };
+
+    static constexpr uint32_t kDefaultSlotSize = 4096;
+    static constexpr uint32_t kDefaultSlotCount = 1024;
+
+    // Server side creates (replacing any stale segment) and owns the segment
+    // and socket paths; the client attaches to an existing one.
+    static std::unique_ptr<ShmChannel> create(const std::string& name,
+                                              uint32_t slotSize = kDefaultSlotSize,
+                                              uint32_t slotCount = kDefaultSlotCount);
+    static std::unique_ptr<ShmChannel> connect(const std::string& name);
+
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel&) = delete;
+    ShmChannel& operator=(const ShmChannel&) = delete;
+
+    // Non-blocking send; false when the peer's ring is full.
+    bool trySend(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length);
+    // Yields while the ring is full for up to timeoutMs; false on timeout or
+    // when the message can never fit a slot.
+    bool send(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length, int timeoutMs);
+    bool tryReceive(std::vector<uint8_t>& message) { return m_inbound.tryPop(message); }
+    // Waits up to timeoutMs (-1 = forever) for a message.
+    bool receive(std::vector<uint8_t>& message, int timeoutMs);
+
+    size_t maxMessageSize() const { return m_outbound.maxMessageSize(); }
+    size_t inboundDepth() const { return m_inbound.depth(); }
+    // Wakes a thread blocked in receive() on this side.
+    void interrupt();
+
+private:
+    ShmChannel(Role role, std::string name);
+
+    bool map(bool create, uint32_t slotSize, uint32_t slotCount);
+    bool openSockets();
+    void ringDoorbell();
+
+    Role m_role;
+    std::string m_name;
+    std::string m_shmName;
+    std::string m_localSocketPath;
+    std::string m_peerSocketPath;
+    void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    int m_socket = -1;
+    ShmRing m_inbound;
+    ShmRing m_outbound;
+};
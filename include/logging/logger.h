@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel : uint8_t { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+// Statements below this level are compiled out entirely (arguments are not
+// evaluated). Override with -DHUB_LOG_LEVEL=<0..5>.
+#ifndef HUB_LOG_LEVEL
+#define HUB_LOG_LEVEL 2
+#endif
+
+#define HUB_LOG(level, ...)                                                   \
+    do {                                                                      \
+        if constexpr (static_cast<int>(level) >= HUB_LOG_LEVEL) {             \
+            Logger& hubLogger_ = Logger::instance();                          \
+            if (hubLogger_.isEnabled(level)) {                                \
+                hubLogger_.log(level, __VA_ARGS__);                           \
+            }                                                                 \
+        }                                                                     \
+    } while (0)
+
+#define HUB_LOG_TRACE(...) HUB_LOG(LogLevel::Trace, __VA_ARGS__)
+#define HUB_LOG_DEBUG(...) HUB_LOG(LogLevel::Debug, __VA_ARGS__)
+#define HUB_LOG_INFO(...) HUB_LOG(LogLevel::Info, __VA_ARGS__)
+#define HUB_LOG_WARN(...) HUB_LOG(LogLevel::Warn, __VA_ARGS__)
+#define HUB_LOG_ERROR(...) HUB_LOG(LogLevel::Error, __VA_ARGS__)
+
+// A log statement captured in binary form. The format string must be a
+// literal; arguments are stored raw and only rendered on the writer thread.
+struct LogRecord {
+    static constexpr size_t kMaxArgs = 6;
+    static constexpr size_t kTextBytes = 128;
+
+    enum class ArgType : uint8_t { Int, UInt, Double, Bool, Text };
+
+    struct Arg {
+        ArgType type;
+        uint8_t textLength;  // Text only; offset is textOffset
+        uint8_t textOffset;
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+        };
+    };
+
+    uint64_t timestampNs;
+    const char* format;
+    LogLevel level;
+    uint8_t argCount;
+    uint8_t textUsed;
+    bool truncated;
+    Arg args[kMaxArgs];
+    char text[kTextBytes];
+};
+
+// Single-producer/single-consumer ring owned by one logging thread.
+class LogRing {
+public:
+    static constexpr size_t kCapacity = 1024;
+
+    LogRecord* beginWrite();
+    void commitWrite();
+    bool read(LogRecord& out);
+    // Records waiting to be read; a snapshot when called off the consumer thread.
+    size_t size() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> retired{false};
+
+private:
+    alignas(64) std::atomic<size_t> m_head{0};  // next slot to write
+    alignas(64) std::atomic<size_t> m_tail{0};  // next slot to read
+    alignas(64) LogRecord m_records[kCapacity];
+};
+
+class Logger {
+public:
+    // Never destroyed, so statements in static destructors stay valid;
+    // pending records are flushed at exit.
+    static Logger& instance();
+
+    bool isEnabled(LogLevel level) const {
+        return static_cast<uint8_t>(level) >= m_runtimeLevel.load(std::memory_order_relaxed);
+    }
+    void setLevel(LogLevel level) { m_runtimeLevel.store(static_cast<uint8_t>(level), std::memory_order_relaxed); }
+
+    // Destination for rendered lines; defaults to stderr. The logger does not
+    // take ownership of the stream.
+    void setSink(std::FILE* sink);
+
+    // Blocks until every record enqueued before the call has been written.
+    void flush();
+
+    // Records discarded because a thread's ring was full.
+    uint64_t droppedCount() const;
+
+    template <size_t N, typename... Args>
+    void log(LogLevel level, const char (&format)[N], const Args&... args) {
+        static_assert(sizeof...(Args) <= LogRecord::kMaxArgs, "too many log arguments");
+        LogRing& ring = threadRing();
+        LogRecord* record = ring.beginWrite();
+        if (!record) {
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        record->timestampNs = nowNs();
+        record->format = format;
+        record->level = level;
+        record->argCount = 0;
+        record->textUsed = 0;
+        record->truncated = false;
+        (capture(*record, args), ...);
+        ring.commitWrite();
+    }
+
+private:
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    static uint64_t nowNs();
+    LogRing& threadRing();
+
+    static void captureText(LogRecord& record, const char* text, size_t length);
+
+    template <typename T>
+    static void capture(LogRecord& record, const T& value) {
+        using D = std::decay_t<T>;
+        LogRecord::Arg& arg = record.args[record.argCount];
+        if constexpr (std::is_same_v<D, bool>) {
+            arg.type = LogRecord::ArgType::Bool;
+            arg.u = value ? 1 : 0;
+        } else if constexpr (std::is_same_v<D, char>) {
+            captureText(record, &value, 1);
+            return;
+        } else if constexpr (std::is_integral_v<D> && std::is_signed_v<D>) {
+            arg.type = LogRecord::ArgType::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral_v<D> || std::is_enum_v<D>) {
+            arg.type = LogRecord::ArgType::UInt;
+            arg.u = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_floating_point_v<D>) {
+            arg.type = LogRecord::ArgType::Double;
+            arg.d = static_cast<double>(value);
+        } else if constexpr (std::is_same_v<D, std::string>) {
+            captureText(record, value.data(), value.size());
+            return;
+        } else {
+            static_assert(std::is_convertible_v<D, const char*>, "unsupported log argument type");
+            const char* text = value;
+            captureText(record, text ? text : "(null)", text ? std::strlen(text) : 6);
+            return;
+        }
+        ++record.argCount;
+    }
+
+    void writerLoop();
+    size_t drainOnce(std::string& line);
+    void render(const LogRecord& record, std::string& line);
+
+    std::atomic<uint8_t> m_runtimeLevel{static_cast<uint8_t>(LogLevel::Trace)};
+    std::atomic<std::FILE*> m_sink;
+
+    mutable std::mutex m_ringsMutex;
+    std::vector<std::shared_ptr<LogRing>> m_rings;
+    uint64_t m_retiredDropped = 0;
+
+    std::mutex m_flushMutex;
+    std::condition_variable m_flushCv;
+    uint64_t m_flushRequests = 0;
+    uint64_t m_flushCompleted = 0;
+};
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Monotonic event count. Updates are relaxed atomics on a private cache line.
+class Counter {
+public:
+    void add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<uint64_t> m_value{0};
+};
+
+// Point-in-time level such as a queue depth.
+class Gauge {
+public:
+    void set(int64_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    void sub(int64_t n = 1) { m_value.fetch_sub(n, std::memory_order_relaxed); }
+    int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    alignas(64) std::atomic<int64_t> m_value{0};
+};
+
+// HDR-style log-linear histogram of nanosecond latencies: every power of two
+// is split into kSubBuckets linear buckets, bounding relative error to about
+// 1/kSubBuckets across the full 64-bit range with a fixed 8 KiB footprint.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    void record(uint64_t ns) {
+        m_buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket holding the q-quantile (0 < q <= 1).
+    uint64_t percentile(double q) const;
+
+    static int bucketFor(uint64_t ns) {
+        if (ns < kSubBuckets) {
+            return static_cast<int>(ns);
+        }
+        int msb = 63 - __builtin_clzll(ns);
+        int shift = msb - kSubBucketBits;
+        int sub = static_cast<int>((ns >> shift) & (kSubBuckets - 1));
+        return (shift + 1) * kSubBuckets + sub;
+    }
+    static uint64_t bucketUpperBound(int bucket);
+
+private:
+    std::atomic<uint64_t> m_buckets[kBuckets] = {};
+    alignas(64) std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+// Records the lifetime of a scope into a histogram and, at trace log level,
+// emits it as a span with its name.
+class TraceSpan {
+public:
+    TraceSpan(const char* name, LatencyHistogram& histogram)
+        : m_name(name), m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    LatencyHistogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Process-wide named metrics. Lookups take a lock, so call sites resolve
+// their metrics once and keep the reference; updates are lock-free.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& instance();
+
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    LatencyHistogram& histogram(const std::string& name);
+
+    // Prometheus-style text exposition of every registered metric.
+    std::string renderText() const;
+
+private:
+    MetricsRegistry() = default;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Counter>> m_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms;
+};
+
+// Periodically writes MetricsRegistry::renderText() to a file (atomically via
+// rename) for the Node dashboard to poll.
+class MetricsExporter {
+public:
+    MetricsExporter(std::string path, std::chrono::milliseconds interval);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    bool writeNow();
+
+private:
+    void run();
+
+    std::string m_path;
+    std::chrono::milliseconds m_interval;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
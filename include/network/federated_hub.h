@@ -0,0 +1,159 @@
+#pragma once
+
+#include "business/hub_service.h"
+#include "core/consistent_hash_ring.h"
+#include "core/timer_wheel.h"
+#include "ipc/hub_ipc.h"
+#include "ipc/hub_ipc_protocol.h"
+#include "network/network_simulator.h"
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Joins several trailers' hubs into one market. Listings are sharded by
+// consistent hashing on the item name and each shard is kept on
+// `replicationFactor` hubs; preorders follow their item to the same shard,
+// so any hub can take a preorder for stock held elsewhere.
+//
+// Requests use the IPC wire format (hub_ipc_protocol.h) and are executed
+// by a HubIpcServer on the owning hub. Everything bound for one peer is
+// coalesced into a single frame per `batchTicks`, which keeps round trips
+// over the satellite backhaul few.
+//
+// A request that times out marks the hub suspected and moves on to the next
+// replica. Every replicated write is kept until its owner acknowledges it.
+// Writes for a suspected owner are held back as hints, and both hints and
+// unacknowledged writes older than `requestTimeoutTicks` are sent again once
+// the owner is heard from. At most `maxHintsPerHub` unacknowledged writes
+// are kept per hub; the rest are dropped and counted. Failover, replicated
+// and replayed listing writes are applied as upserts, so a write landing on
+// a hub twice never duplicates a listing. Preorders are at-least-once across
+// a failover or a lost frame.
+class FederatedHub {
+public:
+    using HubId = NetworkSimulator::NodeId;
+    using ResponseHandler = std::function<void(IpcStatus status, const std::vector<uint8_t>& payload)>;
+
+    struct Config {
+        size_t replicationFactor = 2;
+        unsigned virtualNodes = 128;
+        uint32_t batchTicks = 50;
+        size_t maxBatchBytes = 16 * 1024;  // flush early past this size
+        uint32_t requestTimeoutTicks = 2000;
+        uint32_t suspectTicks = 10000;
+        size_t maxHintsPerHub = 4096;
+    };
+
+    struct Stats {
+        uint64_t requestsLocal = 0;
+        uint64_t requestsRemote = 0;
+        uint64_t failovers = 0;
+        uint64_t messagesSent = 0;
+        uint64_t framesSent = 0;
+        uint64_t hintsQueued = 0;
+        uint64_t hintsDelivered = 0;  // acknowledged by the owner
+        uint64_t hintsDropped = 0;
+    };
+
+    FederatedHub(NetworkSimulator& network, HubId self, HubService& local, const std::vector<HubId>& members,
+                 Config config);
+    FederatedHub(NetworkSimulator& network, HubId self, HubService& local, const std::vector<HubId>& members)
+        : FederatedHub(network, self, local, members, Config()) {}
+    ~FederatedHub();
+
+    FederatedHub(const FederatedHub&) = delete;
+    FederatedHub& operator=(const FederatedHub&) = delete;
+
+    // Routes an IPC request to the owner of `routingKey`. The handler runs
+    // exactly once, synchronously when this hub owns the key.
+    void submit(IpcOp op, const std::string& routingKey, const std::vector<uint8_t>& payload,
+                ResponseHandler handler);
+
+    void createListing(const Listing& listing, ResponseHandler handler);
+    void updateListing(const std::string& name, int quantity, double price, ResponseHandler handler);
+    void getListing(const std::string& name, ResponseHandler handler);
+    void placePreorder(const Preorder& preorder, ResponseHandler handler);
+    void cancelPreorder(const std::string& itemName, ResponseHandler handler);
+
+    std::vector<HubId> ownersOf(const std::string& key) const;
+    bool isSuspected(HubId hub) const;
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // Frame: uint16 entry count, then per entry uint16 kind, uint32 length
+    // and the body. Request bodies are uint16 failover, string routing key
+    // and an IPC request; Response bodies are IPC messages. Replicate bodies
+    // are a uint64 sequence and an IPC request, and Ack bodies echo the
+    // sequence once the write is applied.
+    enum class EntryKind : uint16_t {
+        Request = 1,
+        Response = 2,
+        Replicate = 3,
+        Ack = 4,
+    };
+
+    struct Pending {
+        FederatedHub* hub;
+        uint32_t requestId;
+        std::string routingKey;
+        std::vector<uint8_t> message;  // IpcHeader + payload
+        std::vector<HubId> owners;
+        size_t attempt = 0;
+        HubId target = 0;
+        ResponseHandler handler;
+        TimerWheel::Timer timeout;
+    };
+
+    struct Unacked {
+        std::vector<uint8_t> request;
+        bool hint = false;  // queued while the owner was suspected
+        bool sent = false;
+        uint64_t sentAt = 0;
+    };
+
+    struct Outbox {
+        std::vector<uint8_t> bytes;
+        uint16_t entries = 0;
+    };
+
+    static void onTimeout(void* context);
+    static void onFlush(void* context);
+
+    void dispatch(Pending& pending);
+    void complete(uint32_t requestId, IpcStatus status, const std::vector<uint8_t>& payload);
+    void executeAsOwner(const std::string& routingKey, bool failover, const std::vector<uint8_t>& request,
+                        std::vector<uint8_t>& response);
+    bool applyReplica(const std::vector<uint8_t>& request);
+    IpcStatus upsertListing(const std::vector<uint8_t>& request);
+
+    void onReceive(HubId from, const std::vector<uint8_t>& frame);
+    void heardFrom(HubId hub);
+    void suspect(HubId hub);
+
+    void replicate(HubId owner, const std::vector<uint8_t>& request);
+    void sendReplica(HubId owner, uint64_t sequence, Unacked& replica);
+    void enqueue(HubId peer, EntryKind kind, const std::vector<uint8_t>& body);
+    void flushPeer(HubId peer, Outbox& outbox);
+    void flushAll();
+
+    NetworkSimulator& m_network;
+    HubId m_self;
+    HubService& m_local;
+    HubIpcServer m_executor;
+    Config m_config;
+    ConsistentHashRing m_ring;
+
+    uint32_t m_nextRequestId = 1;
+    uint64_t m_nextReplica = 1;
+    std::unordered_map<uint32_t, std::unique_ptr<Pending>> m_pending;
+    std::unordered_map<HubId, uint64_t> m_suspectedUntil;
+    // Replicated writes per owner until acknowledged, in send order.
+    std::unordered_map<HubId, std::map<uint64_t, Unacked>> m_unacked;
+    std::unordered_map<HubId, Outbox> m_outboxes;
+    TimerWheel::Timer m_flushTimer{&FederatedHub::onFlush, this};
+    Stats m_stats;
+};
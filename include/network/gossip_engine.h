@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/rotating_bloom_filter.h"
+#include "core/timer_wheel.h"
+#include "crypto/encryption_module.h"
+#include "network/network_simulator.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Gossip relay that carries session keys beyond ultrasonic range over the
+// Wi-Fi mesh (see UltrasonicRangeExtension.md). A node that hears a new
+// announcement hands it to the application and forwards it to at most
+// `fanout` random peers until `hopLimit` is reached. Recently seen message
+// ids live in a RotatingBloomFilter that rotates once per dedup window, or
+// sooner when a generation fills. Announcements older than the window, or
+// stamped before the oldest generation the filter still holds, are refused
+// as expired, so a replay can never slip past the filter.
+//
+// Each hop decrypts with the inbound link key and re-encrypts with the
+// outbound one. Records headed for the same peer are queued and sealed as a
+// single batch every `batchTicks`, subject to a per-peer token bucket, so
+// crypto and framing costs are paid per batch rather than per message.
+class GossipEngine {
+public:
+    using NodeId = NetworkSimulator::NodeId;
+
+    struct Config {
+        size_t fanout = 6;
+        unsigned hopLimit = 12;
+        uint32_t batchTicks = 2;
+        double peerRatePerTick = 8.0;  // records per tick per peer
+        double peerBurst = 64.0;
+        size_t maxQueuedPerPeer = 512;
+        size_t maxBatchRecords = 128;
+        size_t bloomBits = 1 << 14;
+        unsigned bloomHashes = 5;
+        uint64_t dedupWindowTicks = 60000;
+    };
+
+    struct KeyAnnouncement {
+        uint64_t messageId;
+        NodeId origin;
+        uint64_t timestamp;
+        std::vector<uint8_t> key;
+    };
+
+    using KeyHandler = std::function<void(const KeyAnnouncement& announcement, unsigned hops)>;
+
+    // relayed and batchesSent count only what the network accepted.
+    struct Stats {
+        uint64_t received = 0;
+        uint64_t duplicates = 0;
+        uint64_t expired = 0;
+        uint64_t relayed = 0;
+        uint64_t rateLimited = 0;
+        uint64_t batchesSent = 0;
+        uint64_t batchesRejected = 0;
+    };
+
+    GossipEngine(NetworkSimulator& network, NodeId self, Config config);
+    GossipEngine(NetworkSimulator& network, NodeId self) : GossipEngine(network, self, Config()) {}
+    ~GossipEngine();
+
+    GossipEngine(const GossipEngine&) = delete;
+    GossipEngine& operator=(const GossipEngine&) = delete;
+
+    // Peers without a link key are never relayed to or accepted from.
+    void setPeerKey(NodeId peer, const EncryptionModule::Key& key);
+    void setKeyHandler(KeyHandler handler) { m_handler = std::move(handler); }
+
+    // Originates an announcement; returns its message id.
+    uint64_t announce(const std::vector<uint8_t>& key);
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Record {
+        uint64_t messageId;
+        NodeId origin;
+        uint64_t timestamp;
+        uint8_t hops;  // hops travelled on arrival at the receiver
+        std::vector<uint8_t> key;
+    };
+
+    struct Peer {
+        EncryptionModule::Key key;
+        double tokens;
+        uint64_t lastRefill;
+        std::deque<Record> outbox;
+    };
+
+    static void onFlush(void* context);
+    void onReceive(NodeId from, const std::vector<uint8_t>& frame);
+    void rotateIfDue(uint64_t now);
+    void accept(Record record, NodeId from);
+    void relay(const Record& record, NodeId exclude);
+    void flush();
+    bool sendBatch(NodeId peerId, Peer& peer, size_t count);
+
+    NetworkSimulator& m_network;
+    NodeId m_self;
+    Config m_config;
+    KeyHandler m_handler;
+
+    std::unordered_map<NodeId, Peer> m_peers;
+    std::vector<NodeId> m_peerIds;
+    std::vector<NodeId> m_candidates;
+
+    RotatingBloomFilter m_seen;
+    uint64_t m_lastRotation;
+    bool m_rotated = false;
+    // Ids first seen before this tick may have rotated out of m_seen.
+    uint64_t m_forgottenBefore = 0;
+    uint32_t m_nextSequence = 1;
+    // Random start, so a restarted node never reuses a nonce under a
+    // long-lived link key.
+    uint64_t m_nextBatch = 0;
+
+    TimerWheel::Timer m_flushTimer{&GossipEngine::onFlush, this};
+    std::vector<uint8_t> m_plain;
+    Stats m_stats;
+};
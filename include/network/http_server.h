@@ -0,0 +1,93 @@
+#pragma once
+
+#include "core/timer_wheel.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct HttpRequest {
+    std::string_view method;
+    std::string_view path;
+    std::string_view body;
+    bool keepAlive = true;
+};
+
+struct HttpResponse {
+    int status = 200;
+    std::string contentType = "application/json";
+    std::string body;
+    // Additional header lines, each terminated by "\r\n".
+    std::string headers;
+    // Set by a handler whose work blocks (e.g. a durable write). It runs on
+    // a worker thread and fills in the response there; the connection reads
+    // no further requests until it completes. Must own everything it uses,
+    // since the request's views die when the handler returns.
+    std::function<void(HttpResponse&)> deferred;
+};
+
+// Called on a reactor thread; must be thread-safe across reactors and must
+// not block; hand blocking work to HttpResponse::deferred instead.
+using HttpHandler = std::function<void(const HttpRequest&, HttpResponse&)>;
+
+// Event-driven HTTP/1.1 server for the PWA clients on the trailer Wi-Fi.
+// One epoll reactor runs per core, each with its own SO_REUSEPORT listener so
+// the kernel shards accepts without a shared lock. Connections live in a
+// preallocated slab with fixed read buffers carved from one arena per
+// reactor; idle connections are reaped by a per-reactor TimerWheel.
+class HttpServer {
+public:
+    struct Config {
+        std::string bindAddress = "0.0.0.0";
+        uint16_t port = 8080;           // 0 picks an ephemeral port
+        unsigned reactors = 0;          // 0 = one per hardware thread
+        size_t maxConnections = 16384;  // split evenly across reactors
+        size_t readBufferSize = 4096;   // largest request accepted
+        unsigned idleTimeoutSeconds = 30;
+        unsigned workers = 4;           // run deferred handlers; 0 runs them inline
+    };
+
+    HttpServer(Config config, HttpHandler handler);
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    bool start();
+    void stop();
+
+    uint16_t port() const { return m_boundPort; }
+    size_t activeConnections() const;
+
+    class Reactor;
+
+private:
+    struct DeferredJob {
+        Reactor* reactor;
+        uint64_t token;  // connection the response belongs to
+        bool keepAlive;
+        HttpResponse response;
+    };
+
+    void submit(DeferredJob job);
+    void workerLoop();
+
+    Config m_config;
+    HttpHandler m_handler;
+    uint16_t m_boundPort = 0;
+    std::vector<std::unique_ptr<Reactor>> m_reactors;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobReady;
+    std::deque<DeferredJob> m_jobs;
+    bool m_workersStopping = false;
+    std::vector<std::thread> m_workers;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "network/http_server.h"
+
+class HubService;
+
+// REST surface for PWA clients, served by HttpServer:
+//
+//   GET    /health
+//   GET    /listings?offset=&limit=
+//   POST   /listings               {"name": "...", "quantity": n, "price": x}
+//   PUT    /listings/{name}        {"quantity": n, "price": x}
+//   GET    /preorders?offset=&limit=
+//   POST   /preorders              {"itemName": "...", "quantity": n}
+//   DELETE /preorders/{itemName}
+//
+// Quantities must be non-negative integers and prices finite and
+// non-negative. Lists return at most `limit` entries (default 100, max
+// 1000) with the full count in an X-Total-Count header. Mutations are
+// answered from HttpServer's worker threads once durable.
+HttpHandler makeHubHttpHandler(HubService& service);
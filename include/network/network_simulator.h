@@ -0,0 +1,108 @@
+#pragma once
+
+#include "core/timer_wheel.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Deterministic discrete-event stand-in for the Wi-Fi mesh and satellite
+// links. Nodes exchange byte payloads over point-to-point links with a
+// latency, jitter and loss rate; delivery is driven by a TimerWheel whose
+// tick is the simulation's unit of time, so protocol code can also schedule
+// its own timers on wheel(). Single-threaded and seeded, so every run of a
+// scenario is reproducible.
+class NetworkSimulator {
+public:
+    using NodeId = uint32_t;
+    using Receiver = std::function<void(NodeId from, const std::vector<uint8_t>& payload)>;
+
+    struct LinkProfile {
+        uint32_t latencyTicks = 1;
+        uint32_t jitterTicks = 0;
+        double lossRate = 0.0;
+    };
+
+    struct Stats {
+        uint64_t sent = 0;
+        uint64_t delivered = 0;
+        uint64_t dropped = 0;
+        uint64_t bytes = 0;
+    };
+
+    explicit NetworkSimulator(uint64_t seed = 1);
+
+    NetworkSimulator(const NetworkSimulator&) = delete;
+    NetworkSimulator& operator=(const NetworkSimulator&) = delete;
+
+    NodeId addNode();
+    size_t nodeCount() const { return m_nodes.size(); }
+    void setReceiver(NodeId node, Receiver receiver);
+
+    // Links are bidirectional; connecting an existing pair updates it.
+    void connect(NodeId a, NodeId b, const LinkProfile& profile);
+    void connect(NodeId a, NodeId b) { connect(a, b, LinkProfile()); }
+    void disconnect(NodeId a, NodeId b);
+    const std::vector<NodeId>& neighbors(NodeId node) const { return m_nodes[node].neighbors; }
+
+    // Joins every node to `degree` random peers (plus a ring so the graph is
+    // connected), like devices scattered around a camp.
+    void connectRandomMesh(size_t degree, const LinkProfile& profile);
+
+    // A down node silently drops everything sent to or from it.
+    void setNodeUp(NodeId node, bool up);
+    bool isNodeUp(NodeId node) const { return m_nodes[node].up; }
+
+    // Queues `payload` on the link; false if there is no such link or the
+    // sender is down. Loss is decided per payload, and a payload reaching a
+    // down receiver is dropped on arrival, so neither shows up here.
+    bool send(NodeId from, NodeId to, std::vector<uint8_t> payload);
+
+    TimerWheel& wheel() { return m_wheel; }
+    uint64_t now() const { return m_wheel.now(); }
+    std::mt19937_64& random() { return m_random; }
+
+    // Advances time until nothing is pending (or `maxTicks` pass). Returns
+    // the ticks advanced.
+    uint64_t runUntilIdle(uint64_t maxTicks = UINT64_MAX);
+    void runFor(uint64_t ticks);
+
+    const Stats& stats() const { return m_stats; }
+    uint64_t sentBy(NodeId node) const { return m_nodes[node].sent; }
+
+private:
+    struct Link {
+        NodeId peer;
+        LinkProfile profile;
+    };
+
+    struct Node {
+        Receiver receiver;
+        std::vector<Link> links;
+        std::vector<NodeId> neighbors;
+        uint64_t sent = 0;
+        bool up = true;
+    };
+
+    struct Delivery {
+        TimerWheel::Timer timer;
+        NetworkSimulator* network = nullptr;
+        NodeId from = 0;
+        NodeId to = 0;
+        std::vector<uint8_t> payload;
+        Delivery* nextFree = nullptr;
+    };
+
+    static void onDeliver(void* context);
+    const Link* findLink(NodeId from, NodeId to) const;
+    void setLink(NodeId from, NodeId to, const LinkProfile& profile);
+    void removeLink(NodeId from, NodeId to);
+
+    TimerWheel m_wheel;
+    std::mt19937_64 m_random;
+    std::vector<Node> m_nodes;
+    std::deque<Delivery> m_deliveries;  // stable addresses for intrusive timers
+    Delivery* m_freeDeliveries = nullptr;
+    Stats m_stats;
+};
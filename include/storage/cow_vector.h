@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Append-mostly vector stored as a list of shared, fixed-capacity chunks so a
+// consistent image can be taken in O(chunks) by copying chunk pointers. A
+// writer that touches a chunk still referenced by an image clones that chunk
+// first, so images stay frozen while writers carry on.
+//
+// Not thread-safe by itself: image() and every mutation must be serialized
+// by the owner's lock. Images may be read and released on any thread.
+template <typename T, size_t ChunkCapacity = 1024>
+class CowVector {
+public:
+    using Chunk = std::vector<T>;
+
+    class Image {
+    public:
+        size_t size() const { return m_size; }
+
+        template <typename Fn>
+        void forEach(Fn&& fn) const {
+            for (const auto& chunk : m_chunks) {
+                for (const T& value : *chunk) {
+                    fn(value);
+                }
+            }
+        }
+
+    private:
+        friend class CowVector;
+        std::vector<std::shared_ptr<const Chunk>> m_chunks;
+        size_t m_size = 0;
+    };
+
+    struct Position {
+        size_t chunk;
+        size_t offset;
+    };
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    Position push_back(const T& value) {
+        if (m_chunks.empty() || m_chunks.back()->size() >= ChunkCapacity) {
+            m_chunks.push_back(std::make_shared<Chunk>());
+            m_chunks.back()->reserve(ChunkCapacity);
+        } else {
+            detach(m_chunks.size() - 1);
+        }
+        m_chunks.back()->push_back(value);
+        ++m_size;
+        return Position{m_chunks.size() - 1, m_chunks.back()->size() - 1};
+    }
+
+    const T& at(Position position) const { return (*m_chunks[position.chunk])[position.offset]; }
+
+    T& mutableAt(Position position) {
+        detach(position.chunk);
+        return (*m_chunks[position.chunk])[position.offset];
+    }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& chunk : m_chunks) {
+            for (const T& value : *chunk) {
+                fn(value);
+            }
+        }
+    }
+
+    // Visits elements from index `first` on until `fn` returns false. Whole
+    // chunks before `first` are skipped, so paging costs O(chunks + page).
+    template <typename Fn>
+    void forEachFrom(size_t first, Fn&& fn) const {
+        for (const auto& chunk : m_chunks) {
+            if (first >= chunk->size()) {
+                first -= chunk->size();
+                continue;
+            }
+            for (size_t i = first; i < chunk->size(); ++i) {
+                if (!fn((*chunk)[i])) {
+                    return;
+                }
+            }
+            first = 0;
+        }
+    }
+
+    // Removes matching elements, rebuilding only the chunks that contain
+    // one. Positions handed out earlier are invalidated.
+    template <typename Pred>
+    size_t removeIf(Pred&& pred) {
+        size_t removed = 0;
+        std::vector<std::shared_ptr<Chunk>> kept;
+        kept.reserve(m_chunks.size());
+        for (auto& chunk : m_chunks) {
+            size_t matches = 0;
+            for (const T& value : *chunk) {
+                matches += pred(value) ? 1 : 0;
+            }
+            if (matches == 0) {
+                kept.push_back(std::move(chunk));
+                continue;
+            }
+            removed += matches;
+            if (matches == chunk->size()) {
+                continue;
+            }
+            auto filtered = std::make_shared<Chunk>();
+            filtered->reserve(ChunkCapacity);
+            for (const T& value : *chunk) {
+                if (!pred(value)) {
+                    filtered->push_back(value);
+                }
+            }
+            kept.push_back(std::move(filtered));
+        }
+        m_chunks = std::move(kept);
+        m_size -= removed;
+        return removed;
+    }
+
+    Image image() const {
+        Image image;
+        image.m_chunks.assign(m_chunks.begin(), m_chunks.end());
+        image.m_size = m_size;
+        return image;
+    }
+
+    std::vector<T> toVector() const {
+        std::vector<T> values;
+        values.reserve(m_size);
+        forEach([&values](const T& value) { values.push_back(value); });
+        return values;
+    }
+
+private:
+    // use_count() can only be stale-high here (images are created under the
+    // owner's lock and released from anywhere), which costs at most a
+    // needless copy.
+    void detach(size_t index) {
+        if (m_chunks[index].use_count() > 1) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(ChunkCapacity);
+            copy->insert(copy->end(), m_chunks[index]->begin(), m_chunks[index]->end());
+            m_chunks[index] = std::move(copy);
+        }
+    }
+
+    std::vector<std::shared_ptr<Chunk>> m_chunks;
+    size_t m_size = 0;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "business/business_interface.h"
+#include "business/recipient_interface.h"
+#include "storage/write_ahead_log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Durable home of the local market: every listing and preorder mutation is
+// journaled to a WriteAheadLog, and the full state is periodically written
+// as a snapshot so the log can be trimmed. Snapshots are built from
+// copy-on-write images of the interfaces, so writers never wait for one.
+//
+// Layout of the data directory:
+//   snapshot-<lsn>   newest two snapshots (the older one is a fallback)
+//   wal/wal-<lsn>    log segments not yet covered by the older snapshot
+class MarketStore {
+public:
+    struct Options {
+        WriteAheadLog::Options wal;
+        std::chrono::seconds snapshotInterval{300};
+        uint64_t snapshotWalBytes = 64 << 20;  // snapshot early once the log grows this much
+    };
+
+    // Consistent state as of `lsn`, taken under the caller's market lock.
+    struct Image {
+        uint64_t lsn = 0;
+        BusinessInterface::ListingImage listings;
+        RecipientInterface::PreorderImage preorders;
+    };
+
+    // Loads the newest readable snapshot and the log after it into the
+    // (empty) interfaces. Returns nullptr if the directory is unusable or
+    // no snapshot can be read while snapshots exist.
+    static std::unique_ptr<MarketStore> open(const std::string& directory, BusinessInterface& business,
+                                             RecipientInterface& recipient, Options options);
+    static std::unique_ptr<MarketStore> open(const std::string& directory, BusinessInterface& business,
+                                             RecipientInterface& recipient) {
+        return open(directory, business, recipient, Options());
+    }
+
+    ~MarketStore();
+
+    MarketStore(const MarketStore&) = delete;
+    MarketStore& operator=(const MarketStore&) = delete;
+
+    // Journal a mutation before applying it; call under the same lock as
+    // the mutation so log order matches apply order. Returns 0, and the
+    // mutation must not be applied, once the log has failed.
+    uint64_t logCreateListing(const Listing& listing);
+    uint64_t logUpdateListing(const std::string& name, int quantity, double price);
+    uint64_t logPlacePreorder(const Preorder& preorder);
+    uint64_t logCancelPreorder(const std::string& itemName);
+
+    // Group commit: blocks until `lsn` is on disk.
+    bool waitDurable(uint64_t lsn) { return m_wal->waitDurable(lsn); }
+    bool failed() const { return m_wal->failed(); }
+    uint64_t lastLsn() const { return m_wal->lastLsn(); }
+
+    // Under the market lock: marks the point the next image is taken at.
+    void beginSnapshot() { m_wal->rollSegment(); }
+
+    // Off the market lock: persists `image` and trims the log.
+    bool writeSnapshot(const Image& image);
+
+    bool snapshotDue() const;
+
+    // Runs `checkpoint` on a background thread whenever a snapshot is due.
+    void startCheckpointing(std::function<bool()> checkpoint);
+    void stopCheckpointing();
+
+    uint64_t snapshotLsn() const;
+
+private:
+    MarketStore(std::string directory, Options options);
+
+    uint64_t journal(const std::vector<uint8_t>& record);
+
+    std::string m_directory;
+    Options m_options;
+    std::unique_ptr<WriteAheadLog> m_wal;
+
+    mutable std::mutex m_snapshotMutex;
+    std::vector<uint64_t> m_snapshots;  // LSNs of snapshot files, ascending
+    std::chrono::steady_clock::time_point m_lastSnapshot;
+
+    std::mutex m_checkpointMutex;
+    std::condition_variable m_checkpointWake;
+    bool m_checkpointStopping = false;
+    std::thread m_checkpointThread;
+};
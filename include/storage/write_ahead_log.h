@@ -0,0 +1,97 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+
+// Segmented append-only log with group commit. append() only copies the
+// record into a memory buffer and hands back its LSN; a flusher thread writes
+// whatever has accumulated with one write() and one fdatasync(), so every
+// writer waiting in waitDurable() during that sync is committed together.
+//
+// Segments are named wal-<first LSN in hex> in the log directory. Each record
+// is framed as [crc32][length][lsn][payload]; replay stops at the first torn
+// or corrupt record and truncates the log there.
+//
+// A failed write or sync latches the log as failed: the segment is cut back
+// to the last durable record, nothing more is accepted or flushed, and every
+// waiter past the durable LSN is failed.
+class WriteAheadLog {
+public:
+    struct Options {
+        size_t segmentBytes = 64 << 20;
+    };
+
+    using ReplayFn = std::function<void(uint64_t lsn, const uint8_t* payload, size_t length)>;
+
+    // Opens (creating if needed) the log in `directory`, replaying every
+    // record after `afterLsn`. New records continue after the highest LSN
+    // seen, or after `afterLsn` if that is higher. Returns nullptr on I/O
+    // failure.
+    static std::unique_ptr<WriteAheadLog> open(const std::string& directory, uint64_t afterLsn,
+                                               const ReplayFn& replay, Options options);
+    static std::unique_ptr<WriteAheadLog> open(const std::string& directory, uint64_t afterLsn,
+                                               const ReplayFn& replay) {
+        return open(directory, afterLsn, replay, Options());
+    }
+
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Returns the record's LSN, or 0 once the log has failed.
+    uint64_t append(const uint8_t* payload, size_t length);
+
+    // Blocks until `lsn` is on stable storage; false if the log failed first.
+    bool waitDurable(uint64_t lsn);
+    bool failed() const;
+
+    uint64_t lastLsn() const;
+    uint64_t durableLsn() const;
+    uint64_t bytesSinceRoll() const;
+
+    // Starts a new segment with the next flushed batch, so that segments
+    // before it can later be dropped by discardThrough().
+    void rollSegment();
+
+    // Deletes whole segments whose records all have LSN <= `lsn`.
+    void discardThrough(uint64_t lsn);
+
+private:
+    WriteAheadLog(std::string directory, Options options);
+
+    bool openSegment(uint64_t firstLsn);
+    void flushLoop();
+
+    std::string m_directory;
+    Options m_options;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_flushWanted;
+    std::condition_variable m_durable;
+    std::vector<uint8_t> m_pending;
+    uint64_t m_pendingFirstLsn = 0;
+    uint64_t m_lastLsn = 0;
+    uint64_t m_durableLsn = 0;
+    uint64_t m_bytesSinceRoll = 0;
+    bool m_rollRequested = false;
+    bool m_failed = false;
+    bool m_stopping = false;
+
+    // Owned by the flusher thread once it starts (guarded by m_mutex for
+    // discardThrough()).
+    int m_fd = -1;
+    size_t m_segmentSize = 0;
+    std::vector<uint64_t> m_segments;  // first LSN of each segment, ascending
+
+    std::thread m_flusher;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Software stand-in for the air between a hub speaker and a phone
+// microphone, so modem changes can be measured without hardware. The
+// impairments are applied in order:
+//
+//   attenuation -> multipath echoes -> Doppler / clock drift (resampling)
+//   -> competing transmitters -> additive white noise -> 16-bit clipping
+//
+// Noise is set as an SNR against the attenuated direct signal, which makes
+// sweeps comparable across attenuation settings. Deterministic for a given
+// seed.
+class AcousticChannel {
+public:
+    struct Echo {
+        double delaySeconds;
+        double gain;  // relative to the direct path
+    };
+
+    // Another device transmitting at the same time, e.g. a second hub.
+    struct Transmitter {
+        std::vector<int16_t> pcm;
+        double gainDb = 0;     // relative to full scale
+        size_t offset = 0;     // samples after the start of the wanted signal
+    };
+
+    struct Config {
+        int sampleRate = 48000;
+        double attenuationDb = 0;
+        std::vector<Echo> echoes;
+        // Receiver moving towards the speaker at this speed; negative moves away.
+        double velocityMps = 0;
+        // Receiver sample clock error against the transmitter's.
+        double clockDriftPpm = 0;
+        double snrDb = INFINITY;
+        std::vector<Transmitter> transmitters;
+    };
+
+    static constexpr double kSpeedOfSound = 343.0;
+
+    explicit AcousticChannel(Config config, uint64_t seed = 1);
+
+    // What the microphone records while `pcm` plays. The result is longer
+    // than the input by the longest echo, and stretched or squeezed by the
+    // Doppler and drift ratio.
+    std::vector<int16_t> transmit(const std::vector<int16_t>& pcm);
+
+    // Received samples per transmitted sample.
+    double timeScale() const;
+    const Config& config() const { return m_config; }
+
+private:
+    Config m_config;
+    std::mt19937_64 m_random;
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary FSK as spoken by riif-ultrasonic: one frame of `SamplesPerFrame`
+// samples per bit, LSB first, the space tone at `CarrierHz` for 0 and the
+// mark tone at `CarrierHz + SpacingHz` for 1. Every frame starts at phase
+// zero. Frequencies are whole hertz so phases reduce exactly, which lets
+// the tone and detector tables be built by the compiler and the frame
+// loops run over a constant trip count.
+
+namespace modem_detail {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series, accurate to well below one 16-bit step on [-pi/2, pi/2].
+constexpr double sinReduced(double x) {
+    double x2 = x * x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; ++n) {
+        term *= -x2 / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+// sin(2*pi * num / den), reducing in integers first.
+constexpr double sinTurns(int64_t num, int64_t den) {
+    num %= den;
+    if (num < 0) {
+        num += den;
+    }
+    double x = 2.0 * kPi * static_cast<double>(num) / static_cast<double>(den);
+    if (x > kPi) {
+        x -= 2.0 * kPi;
+    }
+    if (x > kPi / 2) {
+        x = kPi - x;
+    } else if (x < -kPi / 2) {
+        x = -kPi - x;
+    }
+    return sinReduced(x);
+}
+
+constexpr double cosTurns(int64_t num, int64_t den) {
+    return sinTurns(4 * num + den, 4 * den);
+}
+
+// Same scaling as riif-ultrasonic: truncate towards zero.
+constexpr int16_t toSample(double value) {
+    return static_cast<int16_t>(value * 32767.0);
+}
+
+}  // namespace modem_detail
+
+template <int SampleRate, int CarrierHz, int SpacingHz, int SamplesPerFrame>
+struct ModemProfile {
+    static_assert(SampleRate > 0 && SamplesPerFrame > 0, "Profile needs a sample rate and frame length.");
+    static_assert(2 * (CarrierHz + SpacingHz) < SampleRate, "Carriers must sit below Nyquist.");
+
+    using Frame = std::array<int16_t, SamplesPerFrame>;
+
+    static constexpr int kSampleRate = SampleRate;
+    static constexpr int kSpaceHz = CarrierHz;
+    static constexpr int kMarkHz = CarrierHz + SpacingHz;
+    static constexpr int kSamplesPerFrame = SamplesPerFrame;
+
+    static constexpr Frame tone(int hz) {
+        Frame frame{};
+        for (int i = 0; i < SamplesPerFrame; ++i) {
+            frame[i] = modem_detail::toSample(modem_detail::sinTurns(int64_t(hz) * i, SampleRate));
+        }
+        return frame;
+    }
+
+    // Reference tones for the detector, cos then sin per carrier.
+    using Basis = std::array<float, SamplesPerFrame>;
+    static constexpr Basis basis(int hz, bool cosine) {
+        Basis basis{};
+        for (int i = 0; i < SamplesPerFrame; ++i) {
+            int64_t phase = int64_t(hz) * i;
+            basis[i] = static_cast<float>(cosine ? modem_detail::cosTurns(phase, SampleRate)
+                                                 : modem_detail::sinTurns(phase, SampleRate));
+        }
+        return basis;
+    }
+
+    static constexpr Frame kSpaceTone = tone(kSpaceHz);
+    static constexpr Frame kMarkTone = tone(kMarkHz);
+    alignas(32) static constexpr Basis kSpaceCos = basis(kSpaceHz, true);
+    alignas(32) static constexpr Basis kSpaceSin = basis(kSpaceHz, false);
+    alignas(32) static constexpr Basis kMarkCos = basis(kMarkHz, true);
+    alignas(32) static constexpr Basis kMarkSin = basis(kMarkHz, false);
+};
+
+// The configurations hubs actually run with.
+using Profile48k15k1k = ModemProfile<48000, 15000, 1000, 480>;
+using Profile48k15k5k = ModemProfile<48000, 15000, 5000, 480>;
+
+template <typename Profile>
+struct FskModem {
+    static constexpr int kFrame = Profile::kSamplesPerFrame;
+
+    // Tone energy as |sum x[n] e^{-jwn}|^2, the quantity Goertzel computes,
+    // but as four correlations against the basis tables. Each lane sums
+    // independently, so the loop vectorizes where Goertzel's recurrence
+    // would serialize on every sample.
+    static bool frameBit(const int16_t* frame) {
+        constexpr int kLanes = 8;
+        float spaceCos[kLanes] = {}, spaceSin[kLanes] = {}, markCos[kLanes] = {}, markSin[kLanes] = {};
+        int i = 0;
+        for (; i + kLanes <= kFrame; i += kLanes) {
+            for (int lane = 0; lane < kLanes; ++lane) {
+                float x = frame[i + lane];
+                spaceCos[lane] += x * Profile::kSpaceCos[i + lane];
+                spaceSin[lane] += x * Profile::kSpaceSin[i + lane];
+                markCos[lane] += x * Profile::kMarkCos[i + lane];
+                markSin[lane] += x * Profile::kMarkSin[i + lane];
+            }
+        }
+        for (; i < kFrame; ++i) {
+            float x = frame[i];
+            spaceCos[0] += x * Profile::kSpaceCos[i];
+            spaceSin[0] += x * Profile::kSpaceSin[i];
+            markCos[0] += x * Profile::kMarkCos[i];
+            markSin[0] += x * Profile::kMarkSin[i];
+        }
+        double sc = 0, ss = 0, mc = 0, ms = 0;
+        for (int lane = 0; lane < kLanes; ++lane) {
+            sc += spaceCos[lane];
+            ss += spaceSin[lane];
+            mc += markCos[lane];
+            ms += markSin[lane];
+        }
+        return mc * mc + ms * ms > sc * sc + ss * ss;
+    }
+
+    // One bit per whole frame; a trailing partial frame is ignored.
+    static void decodeBits(const int16_t* pcm, size_t count, std::vector<bool>& bits) {
+        for (size_t offset = 0; offset + kFrame <= count; offset += kFrame) {
+            bits.push_back(frameBit(pcm + offset));
+        }
+    }
+};
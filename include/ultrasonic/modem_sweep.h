@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ultrasonic/acoustic_channel.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Monte Carlo harness for the ultrasonic modem: for every sweep point,
+// `trialsPerPoint` random payloads go through WaveformSynthesizer, an
+// AcousticChannel and UltrasonicModem, spread across threads. Each trial
+// is seeded from (seed, point, trial), so results don't depend on the
+// thread count.
+class ModemSweep {
+public:
+    struct Modem {
+        int sampleRate = 48000;
+        double f0 = 15000.0;
+        double df = 1000.0;
+        int samplesPerFrame = 480;
+    };
+
+    struct Config {
+        Modem modem;
+        size_t payloadBytes = 16;
+        size_t trialsPerPoint = 200;
+        unsigned threads = 0;  // 0 for one per core
+        uint64_t seed = 1;
+    };
+
+    struct Point {
+        std::string label;
+        AcousticChannel::Config channel;  // sampleRate is taken from the modem
+    };
+
+    struct Result {
+        std::string label;
+        uint64_t trials = 0;
+        uint64_t bits = 0;
+        uint64_t bitErrors = 0;
+        uint64_t payloadsIntact = 0;
+        double airtimeSeconds = 0;
+
+        double bitErrorRate() const { return bits ? static_cast<double>(bitErrors) / bits : 0.0; }
+        // Bits of payloads that arrived intact per second on air.
+        double goodputBps(size_t payloadBytes) const {
+            return airtimeSeconds > 0 ? static_cast<double>(payloadsIntact * payloadBytes * 8) / airtimeSeconds : 0.0;
+        }
+    };
+
+    explicit ModemSweep(Config config);
+
+    // One result per point, in order.
+    std::vector<Result> run(const std::vector<Point>& points) const;
+    void report(std::ostream& out, const std::vector<Result>& results) const;
+
+private:
+    Config m_config;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FSK modem that dispatches once, at construction, to the compile-time
+// decoder matching its settings (see modem_profile.h). Settings with no
+// profile fall back to a Goertzel decoder, so results are the same either
+// way and only the speed differs. Encoding copies one tone table per bit
+// whatever the settings, so there is nothing to specialize there.
+class UltrasonicModem {
+public:
+    // Throws std::runtime_error when the settings can't carry data.
+    UltrasonicModem(int sampleRate, double f0, double df, int samplesPerFrame);
+
+    bool isSpecialized() const { return m_specialized; }
+    int samplesPerFrame() const { return m_samplesPerFrame; }
+
+    // Appends the frames for `length` bytes to `pcm`.
+    void encode(const uint8_t* data, size_t length, std::vector<int16_t>& pcm) const;
+    std::vector<int16_t> encode(const std::string& data) const;
+
+    void decodeBits(const int16_t* pcm, size_t count, std::vector<bool>& bits) const;
+    std::vector<bool> decodeBits(const std::vector<int16_t>& pcm) const;
+    // Whole bytes only; trailing bits short of a byte are dropped.
+    std::string decode(const std::vector<int16_t>& pcm) const;
+
+private:
+    using DecodeFn = void (*)(const UltrasonicModem&, const int16_t*, size_t, std::vector<bool>&);
+
+    static void decodeGeneric(const UltrasonicModem& modem, const int16_t* pcm, size_t count,
+                              std::vector<bool>& bits);
+
+    int m_samplesPerFrame;
+    bool m_specialized = false;
+    DecodeFn m_decode = &UltrasonicModem::decodeGeneric;
+
+    std::vector<int16_t> m_spaceTone;
+    std::vector<int16_t> m_markTone;
+    // Generic decoder only.
+    double m_spaceCoeff = 0;
+    double m_markCoeff = 0;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// FSK transmitter built on a numerically controlled oscillator: a 32-bit
+// phase accumulator indexing a sine table, so carrying phase across
+// symbols costs nothing. The NCO only runs to fill symbol tables, one per
+// (bit, starting phase) pair. When a frame spans whole carrier cycles, as
+// in the standard 48 kHz profiles, that is two tables and encoding is a
+// memcpy per bit. Settings that wander through more phases than
+// `maxSymbolTables` synthesize the overflow directly.
+//
+// Payloads sent again and again (announcement beacons, retransmits) can be
+// kept as finished PCM in an LRU cache bounded by `cacheBytes`.
+//
+// Not thread-safe; owned by one LocalCommunication.
+class WaveformSynthesizer {
+public:
+    struct Config {
+        // Off reproduces riif-ultrasonic's frames, each starting at phase
+        // zero. Both decode the same, since detection ignores phase.
+        bool continuousPhase = true;
+        size_t maxSymbolTables = 64;
+        size_t cacheBytes = 8 * 1024 * 1024;
+    };
+
+    struct Stats {
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+        uint64_t cacheEvictions = 0;
+        size_t cachedBytes = 0;
+        size_t symbolTables = 0;
+    };
+
+    using Pcm = std::shared_ptr<const std::vector<int16_t>>;
+
+    WaveformSynthesizer(int sampleRate, double f0, double df, int samplesPerFrame, Config config);
+    WaveformSynthesizer(int sampleRate, double f0, double df, int samplesPerFrame)
+        : WaveformSynthesizer(sampleRate, f0, df, samplesPerFrame, Config()) {}
+
+    // Appends the frames for `length` bytes to `pcm`, LSB first. Every call
+    // starts a new transmission at phase zero.
+    void synthesize(const uint8_t* data, size_t length, std::vector<int16_t>& pcm);
+    std::vector<int16_t> synthesize(const std::string& data);
+
+    // Same samples as synthesize(), from the cache when this payload was
+    // seen recently. The result stays valid after eviction.
+    Pcm cached(const std::string& payload);
+    void clearCache();
+
+    int samplesPerFrame() const { return m_samplesPerFrame; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    static constexpr int kTableBits = 12;
+
+    uint32_t accumulatorPhase(uint64_t phase) const;
+    void runOscillator(bool bit, uint32_t phase, int16_t* out) const;
+    // Null once `maxSymbolTables` are built and this one isn't among them.
+    const int16_t* symbolTable(bool bit, uint64_t phase);
+
+    int m_samplesPerFrame;
+    uint32_t m_spaceStep = 0;
+    uint32_t m_markStep = 0;
+    // Symbol start phases count in 1/m_phaseModulus cycles.
+    uint64_t m_phaseModulus = 1;
+    uint64_t m_spaceAdvance = 0;
+    uint64_t m_markAdvance = 0;
+    Config m_config;
+    std::vector<int16_t> m_sine;  // one cycle, 2^kTableBits entries
+    std::unordered_map<uint64_t, std::vector<int16_t>> m_symbols;
+
+    using LruList = std::list<std::pair<std::string, Pcm>>;
+    LruList m_lru;  // most recent first
+    std::unordered_map<std::string, LruList::iterator> m_cache;
+    Stats m_stats;
+};
@@ -0,0 +1,62 @@
+const fs = require('fs');
+
+// Default location of the file written by the C++ MetricsExporter.
+const DEFAULT_METRICS_PATH = process.env.HUB_METRICS_PATH || '/tmp/disaster_relief_hub.prom';
+
+// Parses the Prometheus-style text written by MetricsRegistry::renderText().
+// Returns { counters, gauges, summaries } keyed by metric name.
+function parseHubMetrics(text) {
+  const types = {};
+  const result = { counters: {}, gauges: {}, summaries: {} };
+
+  for (const line of text.split('\n')) {
+    if (!line) continue;
+    if (line.startsWith('# TYPE ')) {
+      const [, , name, type] = line.split(' ');
+      types[name] = type;
+      continue;
+    }
+
+    const [key, rawValue] = line.split(' ');
+    const value = Number(rawValue);
+    const quantile = key.match(/^(\w+)\{quantile="([\d.]+)"\}$/);
+    if (quantile) {
+      const summary = (result.summaries[quantile[1]] ||= { quantiles: {} });
+      summary.quantiles[quantile[2]] = value;
+      continue;
+    }
+
+    const suffix = key.match(/^(\w+)_(max|sum|count)$/);
+    if (suffix && types[suffix[1]] === 'summary') {
+      const summary = (result.summaries[suffix[1]] ||= { quantiles: {} });
+      summary[suffix[2]] = value;
+    } else if (types[key] === 'counter') {
+      result.counters[key] = value;
+    } else if (types[key] === 'gauge') {
+      result.gauges[key] = value;
+    }
+  }
+  return result;
+}
+
+// Polls the hub metrics file and calls onUpdate with the parsed snapshot.
+// Returns a function that stops polling.
+function watchHubMetrics(onUpdate, { path = DEFAULT_METRICS_PATH, intervalMs = 1000 } = {}) {
+  let lastMtime = 0;
+  const timer = setInterval(async () => {
+    try {
+      const stat = await fs.promises.stat(path);
+      if (stat.mtimeMs === lastMtime) return;
+      lastMtime = stat.mtimeMs;
+      const text = await fs.promises.readFile(path, 'utf8');
+      onUpdate(parseHubMetrics(text));
+    } catch (err) {
+      if (err.code !== 'ENOENT') {
+        console.error('Failed to read hub metrics:', err.message);
+      }
+    }
+  }, intervalMs);
+  return () => clearInterval(timer);
+}
+
+module.exports = { parseHubMetrics, watchHubMetrics, DEFAULT_METRICS_PATH };
@@ -1,24 +1,56 @@
 #include "business/business_interface.h"
 #include "network/satellite_hub.h"
+#include <algorithm>
 
 BusinessInterface::BusinessInterface(SatelliteHub* hub) : m_hub(hub) {}
 
 bool BusinessInterface::createListing(const Listing& listing) {
-    m_listings.push_back(listing);
+    auto position = m_listings.push_back(listing);
+    m_byName.emplace(listing.name, position);
     return true;
 }
 
 bool BusinessInterface::updateListing(const std::string& name, int newQuantity, double newPrice) {
-    for (auto& listing : m_listings) {
-        if (listing.name == name) {
-            listing.quantity = newQuantity;
-            listing.price = newPrice;
-            return true;
-        }
+    auto it = m_byName.find(name);
+    if (it == m_byName.end()) {
+        return false;
     }
-    return false;
+    Listing& listing = m_listings.mutableAt(it->second);
+    listing.quantity = newQuantity;
+    listing.price = newPrice;
+    return true;
 }
 
 std::vector<Listing> BusinessInterface::getListings() const {
-    return m_listings;
+    return m_listings.toVector();
+}
+
+std::vector<Listing> BusinessInterface::getListings(size_t offset, size_t limit) const {
+    std::vector<Listing> page;
+    if (limit == 0) {
+        return page;
+    }
+    page.reserve(std::min(limit, m_listings.size() - std::min(offset, m_listings.size())));
+    m_listings.forEachFrom(offset, [&](const Listing& listing) {
+        page.push_back(listing);
+        return page.size() < limit;
+    });
+    return page;
+}
+
+bool BusinessInterface::findListing(const std::string& name, Listing& listing) const {
+    auto it = m_byName.find(name);
+    if (it == m_byName.end()) {
+        return false;
+    }
+    listing = m_listings.at(it->second);
+    return true;
+}
+
+BusinessInterface::ListingImage BusinessInterface::image() const {
+    return m_listings.image();
+}
+
+size_t BusinessInterface::listingCount() const {
+    return m_listings.size();
 }
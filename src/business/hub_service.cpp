@@ -0,0 +1,169 @@
+#include "business/hub_service.h"
+#include "network/satellite_hub.h"
+#include <cmath>
+#include <stdexcept>
+
+namespace {
+
+const char kTransactionPrefix[] = "TX:";
+
+}  // namespace
+
+HubService::HubService(SatelliteHub* hub) : m_hub(hub), m_business(hub), m_recipient(hub) {}
+
+bool HubService::enableDurability(const std::string& directory, MarketStore::Options options) {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    if (m_store) {
+        throw std::runtime_error("Durability is already enabled.");
+    }
+    m_store = MarketStore::open(directory, m_business, m_recipient, options);
+    if (!m_store) {
+        return false;
+    }
+    m_store->startCheckpointing([this] { return checkpoint(); });
+    return true;
+}
+
+bool HubService::checkpoint() {
+    MarketStore::Image image;
+    {
+        std::lock_guard<std::mutex> lock(m_marketMutex);
+        if (!m_store) {
+            return false;
+        }
+        image.lsn = m_store->lastLsn();
+        image.listings = m_business.image();
+        image.preorders = m_recipient.image();
+        m_store->beginSnapshot();
+    }
+    // The image may include records still in flight; never persist one whose
+    // batch then fails.
+    if (!m_store->waitDurable(image.lsn)) {
+        return false;
+    }
+    return m_store->writeSnapshot(image);
+}
+
+bool HubService::isValid(const Listing& listing) {
+    return listing.quantity >= 0 && std::isfinite(listing.price) && listing.price >= 0;
+}
+
+bool HubService::isValid(const Preorder& preorder) {
+    return preorder.quantity > 0;
+}
+
+bool HubService::createListing(const Listing& listing) {
+    if (!isValid(listing)) {
+        return false;
+    }
+    uint64_t lsn = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_marketMutex);
+        if (m_store && (lsn = m_store->logCreateListing(listing)) == 0) {
+            return false;
+        }
+        m_business.createListing(listing);
+    }
+    return commit(lsn);
+}
+
+bool HubService::updateListing(const std::string& name, int newQuantity, double newPrice) {
+    if (!isValid(Listing{name, newQuantity, newPrice})) {
+        return false;
+    }
+    uint64_t lsn = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_marketMutex);
+        Listing existing;
+        if (!m_business.findListing(name, existing) ||
+            (m_store && (lsn = m_store->logUpdateListing(name, newQuantity, newPrice)) == 0)) {
+            return false;
+        }
+        m_business.updateListing(name, newQuantity, newPrice);
+    }
+    return commit(lsn);
+}
+
+std::vector<Listing> HubService::getListings() const {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    return m_business.getListings();
+}
+
+std::vector<Listing> HubService::getListings(size_t offset, size_t limit, size_t& total) const {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    total = m_business.listingCount();
+    return m_business.getListings(offset, limit);
+}
+
+bool HubService::findListing(const std::string& name, Listing& listing) const {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    return m_business.findListing(name, listing);
+}
+
+bool HubService::placePreorder(const Preorder& preorder) {
+    if (!isValid(preorder)) {
+        return false;
+    }
+    uint64_t lsn = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_marketMutex);
+        if (m_store && (lsn = m_store->logPlacePreorder(preorder)) == 0) {
+            return false;
+        }
+        m_recipient.placePreorder(preorder);
+    }
+    return commit(lsn);
+}
+
+bool HubService::cancelPreorder(const std::string& itemName) {
+    uint64_t lsn = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_marketMutex);
+        if (!m_recipient.hasPreorder(itemName) ||
+            (m_store && (lsn = m_store->logCancelPreorder(itemName)) == 0)) {
+            return false;
+        }
+        m_recipient.cancelPreorder(itemName);
+    }
+    return commit(lsn);
+}
+
+std::vector<Preorder> HubService::getPreorders() const {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    return m_recipient.getPreorders();
+}
+
+std::vector<Preorder> HubService::getPreorders(size_t offset, size_t limit, size_t& total) const {
+    std::lock_guard<std::mutex> lock(m_marketMutex);
+    total = m_recipient.preorderCount();
+    return m_recipient.getPreorders(offset, limit);
+}
+
+// Mutations are journaled before they are applied, so a failed log refuses
+// them outright. The wait happens outside the market lock so concurrent
+// writers share one fdatasync (group commit).
+bool HubService::commit(uint64_t lsn) {
+    return lsn == 0 || m_store->waitDurable(lsn);
+}
+
+bool HubService::submitTransaction(const std::string& transaction) {
+    if (!satelliteSend(kTransactionPrefix + transaction)) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_uplinkMutex);
+    ++m_transactionsSubmitted;
+    return true;
+}
+
+bool HubService::satelliteSend(const std::string& data) {
+    if (!m_hub) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_uplinkMutex);
+    return m_hub->sendData(data);
+}
+
+uint64_t HubService::transactionsSubmitted() const {
+    std::lock_guard<std::mutex> lock(m_uplinkMutex);
+    return m_transactionsSubmitted;
+}
@@ -1,5 +1,6 @@
 #include "business/recipient_interface.h"
 #include "network/satellite_hub.h"
+#include <algorithm>
 
 RecipientInterface::RecipientInterface(SatelliteHub* hub) : m_hub(hub) {}
 
@@ -9,15 +10,39 @@ bool RecipientInterface::placePreorder(const Preorder& preorder) {
 }
 
 bool RecipientInterface::cancelPreorder(const std::string& itemName) {
-    auto it = std::remove_if(m_preorders.begin(), m_preorders.end(),
-                             [&itemName](const Preorder& p) { return p.itemName == itemName; });
-    if (it != m_preorders.end()) {
-        m_preorders.erase(it, m_preorders.end());
-        return true;
-    }
-    return false;
+    return m_preorders.removeIf([&itemName](const Preorder& p) { return p.itemName == itemName; }) > 0;
+}
+
+bool RecipientInterface::hasPreorder(const std::string& itemName) const {
+    bool found = false;
+    m_preorders.forEachFrom(0, [&](const Preorder& p) {
+        found = p.itemName == itemName;
+        return !found;
+    });
+    return found;
 }
 
 std::vector<Preorder> RecipientInterface::getPreorders() const {
-    return m_preorders;
+    return m_preorders.toVector();
+}
+
+std::vector<Preorder> RecipientInterface::getPreorders(size_t offset, size_t limit) const {
+    std::vector<Preorder> page;
+    if (limit == 0) {
+        return page;
+    }
+    page.reserve(std::min(limit, m_preorders.size() - std::min(offset, m_preorders.size())));
+    m_preorders.forEachFrom(offset, [&](const Preorder& preorder) {
+        page.push_back(preorder);
+        return page.size() < limit;
+    });
+    return page;
+}
+
+RecipientInterface::PreorderImage RecipientInterface::image() const {
+    return m_preorders.image();
+}
+
+size_t RecipientInterface::preorderCount() const {
+    return m_preorders.size();
 }
@@ -0,0 +1,76 @@
+#include "core/consistent_hash_ring.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+uint64_t finalize(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDull;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+}
+
+}  // namespace
+
+ConsistentHashRing::ConsistentHashRing(unsigned virtualNodes) : m_virtualNodes(virtualNodes ? virtualNodes : 1) {}
+
+// FNV-1a spreads short, similar names poorly on its own; the murmur
+// finalizer fixes the avalanche.
+uint64_t ConsistentHashRing::hash(const std::string& key) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char c : key) {
+        h = (h ^ c) * 0x100000001B3ull;
+    }
+    return finalize(h);
+}
+
+void ConsistentHashRing::addNode(uint32_t node) {
+    if (contains(node)) {
+        return;
+    }
+    m_nodes.push_back(node);
+    for (unsigned i = 0; i < m_virtualNodes; ++i) {
+        uint64_t position = finalize((static_cast<uint64_t>(node) << 32) ^ (i * 0x9E3779B97F4A7C15ull));
+        m_points.emplace_back(position, node);
+    }
+    std::sort(m_points.begin(), m_points.end());
+}
+
+void ConsistentHashRing::removeNode(uint32_t node) {
+    m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), node), m_nodes.end());
+    m_points.erase(std::remove_if(m_points.begin(), m_points.end(),
+                                  [node](const std::pair<uint64_t, uint32_t>& point) { return point.second == node; }),
+                   m_points.end());
+}
+
+bool ConsistentHashRing::contains(uint32_t node) const {
+    return std::find(m_nodes.begin(), m_nodes.end(), node) != m_nodes.end();
+}
+
+std::vector<uint32_t> ConsistentHashRing::preferenceList(const std::string& key, size_t count) const {
+    std::vector<uint32_t> owners;
+    count = std::min(count, m_nodes.size());
+    if (count == 0) {
+        return owners;
+    }
+    uint64_t position = hash(key);
+    auto it = std::lower_bound(m_points.begin(), m_points.end(), std::make_pair(position, uint32_t(0)));
+    for (size_t step = 0; step < m_points.size() && owners.size() < count; ++step, ++it) {
+        if (it == m_points.end()) {
+            it = m_points.begin();
+        }
+        if (std::find(owners.begin(), owners.end(), it->second) == owners.end()) {
+            owners.push_back(it->second);
+        }
+    }
+    return owners;
+}
+
+uint32_t ConsistentHashRing::owner(const std::string& key) const {
+    if (m_points.empty()) {
+        throw std::runtime_error("Consistent hash ring has no nodes.");
+    }
+    return preferenceList(key, 1).front();
+}
@@ -0,0 +1,68 @@
+#include "core/rotating_bloom_filter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+}  // namespace
+
+RotatingBloomFilter::RotatingBloomFilter(size_t bitsPerGeneration, unsigned hashes)
+    : m_bits(std::max<size_t>(64, (bitsPerGeneration + 63) / 64 * 64)),
+      m_hashes(std::max(1u, hashes)),
+      m_current(m_bits / 64),
+      m_previous(m_bits / 64) {}
+
+// Kirsch-Mitzenmacher double hashing: probe i is h1 + i * h2.
+bool RotatingBloomFilter::test(const std::vector<uint64_t>& bits, uint64_t h1, uint64_t h2) const {
+    for (unsigned i = 0; i < m_hashes; ++i) {
+        uint64_t bit = (h1 + i * h2) % m_bits;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RotatingBloomFilter::contains(uint64_t id) const {
+    uint64_t h1 = mix(id);
+    uint64_t h2 = mix(h1) | 1;
+    return test(m_current, h1, h2) || test(m_previous, h1, h2);
+}
+
+void RotatingBloomFilter::insert(uint64_t id) {
+    uint64_t h1 = mix(id);
+    uint64_t h2 = mix(h1) | 1;
+    for (unsigned i = 0; i < m_hashes; ++i) {
+        uint64_t bit = (h1 + i * h2) % m_bits;
+        m_current[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    ++m_generationSize;
+}
+
+bool RotatingBloomFilter::insertIfAbsent(uint64_t id) {
+    if (contains(id)) {
+        return false;
+    }
+    insert(id);
+    return true;
+}
+
+void RotatingBloomFilter::rotate() {
+    m_previous.swap(m_current);
+    std::fill(m_current.begin(), m_current.end(), 0);
+    m_generationSize = 0;
+}
+
+size_t RotatingBloomFilter::capacity() const {
+    // n = -m * ln(1 - p^(1/k)) / k for p = 1%
+    double perHash = std::pow(0.01, 1.0 / m_hashes);
+    return static_cast<size_t>(-static_cast<double>(m_bits) * std::log(1.0 - perHash) / m_hashes);
+}
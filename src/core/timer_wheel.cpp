@@ -0,0 +1,158 @@
+#include "core/timer_wheel.h"
+
+TimerWheel::TimerWheel(uint64_t startTick) : m_now(startTick) {
+    for (auto& slot : m_root) {
+        slot.m_next = slot.m_prev = &slot;
+    }
+    for (auto& level : m_levels) {
+        for (auto& slot : level) {
+            slot.m_next = slot.m_prev = &slot;
+        }
+    }
+}
+
+TimerWheel::~TimerWheel() {
+    // Detach every pending timer so their destructors don't touch freed slots.
+    auto drain = [](Slot& slot) {
+        while (slot.m_next != &slot) {
+            Timer* timer = slot.m_next;
+            slot.m_next = timer->m_next;
+            timer->m_next = timer->m_prev = nullptr;
+            timer->m_owner = nullptr;
+        }
+        slot.m_prev = &slot;
+    };
+    for (auto& slot : m_root) {
+        drain(slot);
+    }
+    for (auto& level : m_levels) {
+        for (auto& slot : level) {
+            drain(slot);
+        }
+    }
+}
+
+void TimerWheel::schedule(Timer& timer, uint64_t delay) {
+    scheduleAt(timer, m_now + delay);
+}
+
+void TimerWheel::scheduleAt(Timer& timer, uint64_t expiryTick) {
+    timer.unlink();
+    // The current tick's slot has already been expired, so the earliest a new
+    // timer can fire is the next tick.
+    timer.m_expiry = expiryTick > m_now ? expiryTick : m_now + 1;
+    place(timer);
+}
+
+TimerWheel::Slot& TimerWheel::slotFor(uint64_t expiry, int& level) {
+    uint64_t delta = expiry > m_now ? expiry - m_now : 0;
+    level = 0;
+    if (delta < kRootSlots) {
+        return m_root[(m_now + delta) & (kRootSlots - 1)];
+    }
+    if (delta > kMaxSpan) {
+        // Parked in the top level and re-placed on cascade until in range.
+        delta = kMaxSpan;
+    }
+    uint64_t target = m_now + delta;
+    for (int i = 0; i < kLevels - 1; ++i) {
+        int shift = kRootBits + i * kLevelBits;
+        if (delta < (uint64_t(1) << (shift + kLevelBits)) || i == kLevels - 2) {
+            level = i + 1;
+            return m_levels[i][(target >> shift) & (kLevelSlots - 1)];
+        }
+    }
+    return m_levels[kLevels - 2][0];  // unreachable
+}
+
+void TimerWheel::place(Timer& timer) {
+    Slot& slot = slotFor(timer.m_expiry, timer.m_level);
+    timer.m_prev = slot.m_prev;
+    timer.m_next = &slot;
+    slot.m_prev->m_next = &timer;
+    slot.m_prev = &timer;
+    timer.m_owner = this;
+    ++m_pending;
+    ++m_levelPending[timer.m_level];
+}
+
+void TimerWheel::cascade(int level, size_t index) {
+    Slot& slot = m_levels[level][index];
+    // Detach the whole list first; place() may append to other slots of this
+    // level but never back into this one.
+    Timer* timer = slot.m_next;
+    slot.m_next = slot.m_prev = &slot;
+    while (timer != &slot) {
+        Timer* next = timer->m_next;
+        --m_pending;
+        --m_levelPending[level + 1];
+        place(*timer);
+        timer = next;
+    }
+}
+
+size_t TimerWheel::expireSlot(Slot& slot) {
+    if (slot.m_next == &slot) {
+        return 0;
+    }
+    // Splice onto a local list so callbacks can schedule into this slot
+    // (for the next revolution) or cancel siblings without confusing the walk.
+    Timer local;
+    local.m_next = slot.m_next;
+    local.m_prev = slot.m_prev;
+    local.m_next->m_prev = &local;
+    local.m_prev->m_next = &local;
+    slot.m_next = slot.m_prev = &slot;
+
+    size_t fired = 0;
+    while (local.m_next != &local) {
+        Timer* timer = local.m_next;
+        timer->unlink();
+        if (timer->m_callback) {
+            timer->m_callback(timer->m_context);
+        }
+        ++fired;
+    }
+    return fired;
+}
+
+void TimerWheel::skipIdleTicks(uint64_t nowTick) {
+    // With the lowest levels empty, nothing can happen before the next
+    // cascade boundary of the first occupied level.
+    int shift = 0;
+    for (int level = 0; level < kLevels && m_levelPending[level] == 0; ++level) {
+        shift = kRootBits + level * kLevelBits;
+    }
+    if (shift == 0) {
+        return;
+    }
+    if (m_pending == 0) {
+        m_now = nowTick;
+        return;
+    }
+    uint64_t boundary = ((m_now >> shift) + 1) << shift;
+    m_now = boundary - 1 < nowTick ? boundary - 1 : nowTick;
+}
+
+size_t TimerWheel::advanceTo(uint64_t nowTick) {
+    size_t fired = 0;
+    while (m_now < nowTick) {
+        skipIdleTicks(nowTick);
+        if (m_now == nowTick) {
+            break;
+        }
+        ++m_now;
+        if ((m_now & (kRootSlots - 1)) == 0) {
+            for (int level = 0; level < kLevels - 1; ++level) {
+                int shift = kRootBits + level * kLevelBits;
+                size_t index = (m_now >> shift) & (kLevelSlots - 1);
+                cascade(level, index);
+                if (index != 0) {
+                    break;
+                }
+            }
+        }
+        fired += expireSlot(m_root[m_now & (kRootSlots - 1)]);
+    }
+    return fired;
+}
@@ -0,0 +1,47 @@
+#include "crypto/encryption_module.h"
+#include <sodium.h>
+
+static_assert(EncryptionModule::kKeyBytes == crypto_aead_chacha20poly1305_ietf_KEYBYTES, "key size");
+static_assert(EncryptionModule::kNonceBytes == crypto_aead_chacha20poly1305_ietf_NPUBBYTES, "nonce size");
+static_assert(EncryptionModule::kTagBytes == crypto_aead_chacha20poly1305_ietf_ABYTES, "tag size");
+
+bool EncryptionModule::initialize() {
+    // 0 on first initialization, 1 if already done.
+    return sodium_init() >= 0;
+}
+
+EncryptionModule::Key EncryptionModule::generateKey() {
+    Key key;
+    randombytes_buf(key.data(), key.size());
+    return key;
+}
+
+void EncryptionModule::randomBytes(void* out, size_t length) {
+    randombytes_buf(out, length);
+}
+
+void EncryptionModule::seal(const Key& key, const Nonce& nonce, const uint8_t* associated, size_t associatedLength,
+                            const uint8_t* plaintext, size_t length, std::vector<uint8_t>& out) {
+    size_t start = out.size();
+    out.resize(start + length + kTagBytes);
+    unsigned long long sealedLength = 0;
+    crypto_aead_chacha20poly1305_ietf_encrypt(out.data() + start, &sealedLength, plaintext, length, associated,
+                                              associatedLength, nullptr, nonce.data(), key.data());
+    out.resize(start + static_cast<size_t>(sealedLength));
+}
+
+bool EncryptionModule::open(const Key& key, const Nonce& nonce, const uint8_t* associated, size_t associatedLength,
+                            const uint8_t* ciphertext, size_t length, std::vector<uint8_t>& out) {
+    if (length < kTagBytes) {
+        return false;
+    }
+    out.resize(length - kTagBytes);
+    unsigned long long openedLength = 0;
+    if (crypto_aead_chacha20poly1305_ietf_decrypt(out.data(), &openedLength, nullptr, ciphertext, length, associated,
+                                                  associatedLength, nonce.data(), key.data()) != 0) {
+        out.clear();
+        return false;
+    }
+    out.resize(static_cast<size_t>(openedLength));
+    return true;
+}
@@ -1,9 +1,31 @@
 #include "devices/local_communication.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
 #include <algorithm>
 #include <random>
 #include <stdexcept>
+#include <utility>
 
-LocalCommunication::LocalCommunication() {}
+namespace {
+
+struct UltrasonicMetrics {
+    LatencyHistogram& encodeLatency = MetricsRegistry::instance().histogram("ultrasonic_encode_ns");
+    LatencyHistogram& decodeLatency = MetricsRegistry::instance().histogram("ultrasonic_decode_ns");
+    LatencyHistogram& encryptLatency = MetricsRegistry::instance().histogram("ultrasonic_encrypt_ns");
+    Counter& keyExchanges = MetricsRegistry::instance().counter("ultrasonic_key_exchanges");
+    Counter& keyExchangeFailures = MetricsRegistry::instance().counter("ultrasonic_key_exchange_failures");
+};
+
+UltrasonicMetrics& ultrasonicMetrics() {
+    static UltrasonicMetrics metrics;
+    return metrics;
+}
+
+}  // namespace
+
+LocalCommunication::LocalCommunication() {
+    configureModem();
+}
 
 LocalCommunication::~LocalCommunication() {}
 
@@ -11,27 +33,57 @@ bool LocalCommunication::initializeUltrasonic() {
     // Initialize the RiifUltrasonic instance with default parameters
     RiifUltrasonic::Parameters params;
     m_ultrasonic.setParameters(params);
+    configureModem();
     return true;
 }
 
+void LocalCommunication::configureModem() {
+    // The hub's own modem speaks riif-ultrasonic's FSK framing with the same
+    // parameters; the synthesizer replaces per-sample std::sin on send.
+    const RiifUltrasonic::Parameters& params = m_ultrasonic.getParameters();
+    m_modem = std::make_unique<UltrasonicModem>(params.sampleRate, params.f0, params.df, params.samplesPerFrame);
+    m_synthesizer =
+        std::make_unique<WaveformSynthesizer>(params.sampleRate, params.f0, params.df, params.samplesPerFrame);
+}
+
 bool LocalCommunication::performKeyExchange() {
-    // Generate a random key
-    m_sharedKey.resize(32);
+    // Generate a random key. It only replaces the current one once the
+    // exchange succeeds, so a failed rotation leaves both ends in agreement.
+    std::vector<uint8_t> key(32);
     std::random_device rd;
-    std::generate(m_sharedKey.begin(), m_sharedKey.end(), std::ref(rd));
+    std::generate(key.begin(), key.end(), std::ref(rd));
     
+    UltrasonicMetrics& metrics = ultrasonicMetrics();
+
     // Encode and send the key
-    std::string keyStr(m_sharedKey.begin(), m_sharedKey.end());
-    auto encodedKey = m_ultrasonic.encode(keyStr);
+    std::string keyStr(key.begin(), key.end());
+    std::vector<int16_t> encodedKey;
+    {
+        TraceSpan span("ultrasonic_encode", metrics.encodeLatency);
+        encodedKey = m_synthesizer->synthesize(keyStr);
+    }
     
     // Simulate receiving the encoded key
-    auto receivedKeyVec = m_ultrasonic.decode(encodedKey);
-    std::string receivedKeyStr(receivedKeyVec.begin(), receivedKeyVec.end());
+    std::string receivedKeyStr;
+    {
+        TraceSpan span("ultrasonic_decode", metrics.decodeLatency);
+        receivedKeyStr = m_modem->decode(encodedKey);
+    }
     
     // In a real implementation, we would validate the received key
     // and perform additional steps for secure key exchange
     
-    return receivedKeyStr == keyStr;
+    bool exchanged = receivedKeyStr == keyStr;
+    if (exchanged) {
+        std::fill(m_sharedKey.begin(), m_sharedKey.end(), 0);
+        m_sharedKey = std::move(key);
+        metrics.keyExchanges.add();
+        armKeyTimers();
+    } else {
+        metrics.keyExchangeFailures.add();
+        HUB_LOG_WARN("Ultrasonic key exchange failed: decoded key mismatch ({} samples)", encodedKey.size());
+    }
+    return exchanged;
 }
 
 bool LocalCommunication::sendSecureData(const std::string& data) {
@@ -39,16 +91,38 @@ bool LocalCommunication::sendSecureData(const std::string& data) {
         throw std::runtime_error("Shared key not set. Perform key exchange first.");
     }
     
+    UltrasonicMetrics& metrics = ultrasonicMetrics();
+
     // Simple XOR encryption (for demonstration purposes only)
     std::vector<uint8_t> encryptedData(data.begin(), data.end());
-    for (size_t i = 0; i < encryptedData.size(); ++i) {
-        encryptedData[i] ^= m_sharedKey[i % m_sharedKey.size()];
+    {
+        TraceSpan span("ultrasonic_encrypt", metrics.encryptLatency);
+        for (size_t i = 0; i < encryptedData.size(); ++i) {
+            encryptedData[i] ^= m_sharedKey[i % m_sharedKey.size()];
+        }
     }
     
-    m_lastSentData = m_ultrasonic.encode(std::string(encryptedData.begin(), encryptedData.end()));
+    {
+        TraceSpan span("ultrasonic_encode", metrics.encodeLatency);
+        auto pcm = std::make_shared<std::vector<int16_t>>();
+        m_synthesizer->synthesize(encryptedData.data(), encryptedData.size(), *pcm);
+        m_lastSentData = std::move(pcm);
+    }
+    touchSession();
     return true;
 }
 
+bool LocalCommunication::broadcastAnnouncement(const std::string& announcement) {
+    TraceSpan span("ultrasonic_encode", ultrasonicMetrics().encodeLatency);
+    m_lastSentData = m_synthesizer->cached(announcement);
+    return true;
+}
+
+const std::vector<int16_t>& LocalCommunication::lastTransmission() const {
+    static const std::vector<int16_t> kSilence;
+    return m_lastSentData ? *m_lastSentData : kSilence;
+}
+
 bool LocalCommunication::receiveSecureData(std::string& data) {
     if (m_sharedKey.empty()) {
         throw std::runtime_error("Shared key not set. Perform key exchange first.");
@@ -56,8 +130,11 @@ bool LocalCommunication::receiveSecureData(std::string& data) {
     
     // In a real implementation, we would receive actual encoded data
     // For simulation, we'll use the last sent data
-    auto decodedDataVec = m_ultrasonic.decode(m_lastSentData);
-    std::string decodedData(decodedDataVec.begin(), decodedDataVec.end());
+    std::string decodedData;
+    {
+        TraceSpan span("ultrasonic_decode", ultrasonicMetrics().decodeLatency);
+        decodedData = m_modem->decode(lastTransmission());
+    }
     
     // Simple XOR decryption (for demonstration purposes only)
     std::vector<uint8_t> decryptedData(decodedData.begin(), decodedData.end());
@@ -66,5 +143,53 @@ bool LocalCommunication::receiveSecureData(std::string& data) {
     }
     
     data = std::string(decryptedData.begin(), decryptedData.end());
+    touchSession();
     return true;
 }
+
+void LocalCommunication::enableKeyLifecycle(TimerWheel& wheel, uint64_t rotationTicks, uint64_t sessionTimeoutTicks) {
+    m_wheel = &wheel;
+    m_rotationTicks = rotationTicks;
+    m_sessionTimeoutTicks = sessionTimeoutTicks;
+    if (!m_sharedKey.empty()) {
+        armKeyTimers();
+    }
+}
+
+void LocalCommunication::armKeyTimers() {
+    if (!m_wheel) {
+        return;
+    }
+    if (m_rotationTicks > 0) {
+        m_wheel->schedule(m_rotationTimer, m_rotationTicks);
+    }
+    // Rotation isn't traffic: a running session keeps its idle deadline.
+    if (m_sessionTimeoutTicks > 0 && !m_sessionTimer.isPending()) {
+        m_wheel->schedule(m_sessionTimer, m_sessionTimeoutTicks);
+    }
+}
+
+void LocalCommunication::touchSession() {
+    if (m_wheel && m_sessionTimeoutTicks > 0) {
+        m_wheel->schedule(m_sessionTimer, m_sessionTimeoutTicks);
+    }
+}
+
+void LocalCommunication::onKeyRotation(void* context) {
+    auto* self = static_cast<LocalCommunication*>(context);
+    // A fresh exchange re-arms the rotation timer on success. On failure keep
+    // the current key and retry next interval; session expiry still applies.
+    if (!self->performKeyExchange() && self->m_wheel) {
+        self->m_wheel->schedule(self->m_rotationTimer, self->m_rotationTicks);
+    }
+}
+
+void LocalCommunication::onSessionExpired(void* context) {
+    auto* self = static_cast<LocalCommunication*>(context);
+    HUB_LOG_INFO("Ultrasonic session expired after {} idle ticks", self->m_sessionTimeoutTicks);
+    std::fill(self->m_sharedKey.begin(), self->m_sharedKey.end(), 0);
+    self->m_sharedKey.clear();
+    if (self->m_wheel) {
+        self->m_wheel->cancel(self->m_rotationTimer);
+    }
+}
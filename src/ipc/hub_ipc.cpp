@@ -0,0 +1,320 @@
+#include "ipc/hub_ipc.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+struct IpcMetrics {
+    LatencyHistogram& requestLatency = MetricsRegistry::instance().histogram("ipc_request_ns");
+    Counter& requests = MetricsRegistry::instance().counter("ipc_requests");
+    Gauge& queueDepth = MetricsRegistry::instance().gauge("ipc_request_queue_depth");
+    Counter& responsesDropped = MetricsRegistry::instance().counter("ipc_responses_dropped");
+};
+
+IpcMetrics& ipcMetrics() {
+    static IpcMetrics metrics;
+    return metrics;
+}
+
+void writeHeader(std::vector<uint8_t>& out, uint32_t requestId, IpcOp op, IpcStatus status) {
+    IpcHeader header{requestId, static_cast<uint16_t>(op), static_cast<uint16_t>(status), 0};
+    out.resize(sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+void patchPayloadLength(std::vector<uint8_t>& out, IpcStatus status) {
+    IpcHeader header;
+    std::memcpy(&header, out.data(), sizeof(header));
+    header.status = static_cast<uint16_t>(status);
+    header.payloadLength = static_cast<uint32_t>(out.size() - sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+}
+
+// Encoded size of a list entry besides its name: string length prefix plus
+// int32 quantity, and an f64 price for listings.
+constexpr size_t kListingFixedBytes = 2 + 4 + 8;
+constexpr size_t kPreorderFixedBytes = 2 + 4;
+
+// Upper bound on the entries one page can hold, so a page copies only that
+// many out of the market instead of all of it.
+size_t maxEntries(size_t budget, size_t fixedBytes) {
+    return budget / fixedBytes + 1;
+}
+
+// Whether an entry with `name` fits in what's left of the page. The first
+// entry of a page goes in even if its name has to be truncated, so a client
+// paging by offset can't get stuck on it.
+bool fitEntry(std::string& name, size_t fixedBytes, size_t used, size_t budget, uint32_t count) {
+    size_t room = budget > used ? budget - used : 0;
+    if (fixedBytes + name.size() <= room) {
+        return true;
+    }
+    if (count > 0 || room <= fixedBytes) {
+        return false;
+    }
+    name.resize(room - fixedBytes);
+    return true;
+}
+
+// Responses to a client that stops draining its ring are dropped after this
+// long, so a stalled peer can't wedge the serve loop or daemon shutdown.
+constexpr int kResponseTimeoutMs = 1000;
+constexpr int kResponseRetryMs = 100;
+
+}  // namespace
+
+HubIpcServer::HubIpcServer(HubService& service, std::unique_ptr<ShmChannel> channel)
+    : m_service(service), m_channel(std::move(channel)) {}
+
+void HubIpcServer::serve(const std::atomic<bool>& running) {
+    IpcMetrics& metrics = ipcMetrics();
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> response;
+    while (m_channel && running.load(std::memory_order_relaxed)) {
+        if (!m_channel->receive(request, 100)) {
+            continue;
+        }
+        metrics.queueDepth.set(static_cast<int64_t>(m_channel->inboundDepth()));
+        {
+            TraceSpan span("ipc_request", metrics.requestLatency);
+            handle(request, response);
+        }
+        metrics.requests.add();
+        bool sent = false;
+        for (int waited = 0; !sent && waited < kResponseTimeoutMs && running.load(std::memory_order_relaxed);
+             waited += kResponseRetryMs) {
+            sent = m_channel->send(nullptr, 0, response.data(), response.size(), kResponseRetryMs);
+        }
+        if (!sent) {
+            metrics.responsesDropped.add();
+            HUB_LOG_WARN("Dropped {}-byte IPC response: client is not draining its ring", response.size());
+        }
+    }
+}
+
+void HubIpcServer::handle(const std::vector<uint8_t>& request, std::vector<uint8_t>& response) {
+    IpcHeader header{};
+    if (request.size() < sizeof(header)) {
+        writeHeader(response, 0, IpcOp{}, IpcStatus::BadRequest);
+        patchPayloadLength(response, IpcStatus::BadRequest);
+        return;
+    }
+    std::memcpy(&header, request.data(), sizeof(header));
+    size_t payloadLength = std::min<size_t>(header.payloadLength, request.size() - sizeof(header));
+    IpcReader reader(request.data() + sizeof(header), payloadLength);
+
+    IpcOp op = static_cast<IpcOp>(header.op);
+    writeHeader(response, header.requestId, op, IpcStatus::Ok);
+    IpcStatus status = dispatch(op, reader, response);
+    if (status != IpcStatus::Ok) {
+        response.resize(sizeof(IpcHeader));
+    }
+    patchPayloadLength(response, status);
+}
+
+IpcStatus HubIpcServer::dispatch(IpcOp op, IpcReader& reader, std::vector<uint8_t>& payload) {
+    IpcWriter writer(payload);
+    // Responses share the channel's slot size with requests.
+    const size_t budget = m_channel ? m_channel->maxMessageSize() : ShmChannel::kDefaultSlotSize - 4;
+
+    switch (op) {
+        case IpcOp::CreateListing:
+        case IpcOp::UpdateListing: {
+            Listing listing;
+            int32_t quantity;
+            if (!reader.str(listing.name) || !reader.i32(quantity) || !reader.f64(listing.price)) {
+                return IpcStatus::BadRequest;
+            }
+            listing.quantity = quantity;
+            if (!HubService::isValid(listing)) {
+                return IpcStatus::BadRequest;
+            }
+            if (op == IpcOp::CreateListing) {
+                return m_service.createListing(listing) ? IpcStatus::Ok : IpcStatus::Failed;
+            }
+            return m_service.updateListing(listing.name, listing.quantity, listing.price) ? IpcStatus::Ok
+                                                                                          : IpcStatus::NotFound;
+        }
+        case IpcOp::ListListings: {
+            uint32_t offset = 0;
+            if (!reader.u32(offset)) {
+                return IpcStatus::BadRequest;
+            }
+            size_t total = 0;
+            std::vector<Listing> listings = m_service.getListings(offset, maxEntries(budget, kListingFixedBytes), total);
+            size_t countPosition = writer.size() + sizeof(uint32_t);
+            writer.u32(static_cast<uint32_t>(total));
+            writer.u32(0);
+            uint32_t count = 0;
+            for (Listing& listing : listings) {
+                if (!fitEntry(listing.name, kListingFixedBytes, writer.size(), budget, count)) {
+                    break;  // client pages with the next offset
+                }
+                writer.str(listing.name);
+                writer.i32(listing.quantity);
+                writer.f64(listing.price);
+                ++count;
+            }
+            if (count == 0 && !listings.empty()) {
+                return IpcStatus::TooLarge;
+            }
+            std::memcpy(payload.data() + countPosition, &count, sizeof(count));
+            return IpcStatus::Ok;
+        }
+        case IpcOp::PlacePreorder: {
+            Preorder preorder;
+            int32_t quantity;
+            if (!reader.str(preorder.itemName) || !reader.i32(quantity)) {
+                return IpcStatus::BadRequest;
+            }
+            preorder.quantity = quantity;
+            if (!HubService::isValid(preorder)) {
+                return IpcStatus::BadRequest;
+            }
+            return m_service.placePreorder(preorder) ? IpcStatus::Ok : IpcStatus::Failed;
+        }
+        case IpcOp::CancelPreorder: {
+            std::string itemName;
+            if (!reader.str(itemName)) {
+                return IpcStatus::BadRequest;
+            }
+            return m_service.cancelPreorder(itemName) ? IpcStatus::Ok : IpcStatus::NotFound;
+        }
+        case IpcOp::ListPreorders: {
+            uint32_t offset = 0;
+            if (!reader.u32(offset)) {
+                return IpcStatus::BadRequest;
+            }
+            size_t total = 0;
+            std::vector<Preorder> preorders =
+                m_service.getPreorders(offset, maxEntries(budget, kPreorderFixedBytes), total);
+            size_t countPosition = writer.size() + sizeof(uint32_t);
+            writer.u32(static_cast<uint32_t>(total));
+            writer.u32(0);
+            uint32_t count = 0;
+            for (Preorder& preorder : preorders) {
+                if (!fitEntry(preorder.itemName, kPreorderFixedBytes, writer.size(), budget, count)) {
+                    break;
+                }
+                writer.str(preorder.itemName);
+                writer.i32(preorder.quantity);
+                ++count;
+            }
+            if (count == 0 && !preorders.empty()) {
+                return IpcStatus::TooLarge;
+            }
+            std::memcpy(payload.data() + countPosition, &count, sizeof(count));
+            return IpcStatus::Ok;
+        }
+        case IpcOp::GetListing: {
+            std::string name;
+            Listing listing;
+            if (!reader.str(name)) {
+                return IpcStatus::BadRequest;
+            }
+            if (!m_service.findListing(name, listing)) {
+                return IpcStatus::NotFound;
+            }
+            writer.str(listing.name);
+            writer.i32(listing.quantity);
+            writer.f64(listing.price);
+            return IpcStatus::Ok;
+        }
+        case IpcOp::SubmitTransaction:
+            return m_service.submitTransaction(reader.rest()) ? IpcStatus::Ok : IpcStatus::Failed;
+        case IpcOp::SatelliteSend:
+            return m_service.satelliteSend(reader.rest()) ? IpcStatus::Ok : IpcStatus::Failed;
+    }
+    HUB_LOG_WARN("Unknown IPC op {}", static_cast<unsigned>(op));
+    return IpcStatus::UnknownOp;
+}
+
+HubIpcClient::HubIpcClient(std::unique_ptr<ShmChannel> channel) : m_channel(std::move(channel)) {}
+
+bool HubIpcClient::post(IpcOp op, const std::vector<uint8_t>& payload, uint32_t& requestId) {
+    IpcHeader header{m_nextRequestId, static_cast<uint16_t>(op), 0, static_cast<uint32_t>(payload.size())};
+    if (!m_channel->trySend(reinterpret_cast<const uint8_t*>(&header), sizeof(header), payload.data(),
+                            payload.size())) {
+        return false;
+    }
+    requestId = m_nextRequestId++;
+    return true;
+}
+
+bool HubIpcClient::poll(IpcHeader& header, std::vector<uint8_t>& payload, int timeoutMs) {
+    if (!m_channel->receive(m_message, timeoutMs) || m_message.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, m_message.data(), sizeof(header));
+    payload.assign(m_message.begin() + sizeof(header), m_message.end());
+    return true;
+}
+
+IpcStatus HubIpcClient::call(IpcOp op, const std::vector<uint8_t>& payload, std::vector<uint8_t>& response,
+                             int timeoutMs) {
+    if (sizeof(IpcHeader) + payload.size() > m_channel->maxMessageSize()) {
+        return IpcStatus::TooLarge;
+    }
+    uint32_t requestId;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!post(op, payload, requestId)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return IpcStatus::Failed;
+        }
+        std::this_thread::yield();
+    }
+    IpcHeader header;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (poll(header, response, 100) && header.requestId == requestId) {
+            return static_cast<IpcStatus>(header.status);
+        }
+    }
+    return IpcStatus::Failed;
+}
+
+IpcStatus HubIpcClient::createListing(const Listing& listing) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(listing.name);
+    writer.i32(listing.quantity);
+    writer.f64(listing.price);
+    std::vector<uint8_t> response;
+    return call(IpcOp::CreateListing, payload, response);
+}
+
+IpcStatus HubIpcClient::placePreorder(const Preorder& preorder) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(preorder.itemName);
+    writer.i32(preorder.quantity);
+    std::vector<uint8_t> response;
+    return call(IpcOp::PlacePreorder, payload, response);
+}
+
+IpcStatus HubIpcClient::listListings(uint32_t offset, std::vector<Listing>& listings, uint32_t& total) {
+    std::vector<uint8_t> payload;
+    IpcWriter(payload).u32(offset);
+    std::vector<uint8_t> response;
+    IpcStatus status = call(IpcOp::ListListings, payload, response);
+    if (status != IpcStatus::Ok) {
+        return status;
+    }
+    IpcReader reader(response.data(), response.size());
+    uint32_t count;
+    if (!reader.u32(total) || !reader.u32(count)) {
+        return IpcStatus::BadRequest;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        Listing listing;
+        int32_t quantity;
+        if (!reader.str(listing.name) || !reader.i32(quantity) || !reader.f64(listing.price)) {
+            return IpcStatus::BadRequest;
+        }
+        listing.quantity = quantity;
+        listings.push_back(listing);
+    }
+    return IpcStatus::Ok;
+}
@@ -0,0 +1,286 @@
+#include "ipc/shm_channel.h"
+#include "logging/logger.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <new>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t kSegmentMagic = 0x48554231;  // "HUB1"
+constexpr int kSpinIterations = 2000;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t slotSize;
+    uint32_t slotCount;
+    uint32_t reserved;
+};
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t ringHeaderBytes() {
+    return alignUp(sizeof(ShmRingHeader), 64);
+}
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+void sendDoorbell(int socket, const std::string& path) {
+    sockaddr_un address = socketAddress(path);
+    char byte = 1;
+    // A missing or backed-up peer socket just means nobody is asleep on it.
+    ::sendto(socket, &byte, 1, MSG_DONTWAIT, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+}
+
+}  // namespace
+
+size_t ShmRing::bytesFor(uint32_t slotSize, uint32_t slotCount) {
+    return ringHeaderBytes() + static_cast<size_t>(slotSize) * slotCount;
+}
+
+void ShmRing::initialize(uint32_t slotSize, uint32_t slotCount) {
+    m_header->slotSize = slotSize;
+    m_header->slotCount = slotCount;
+    m_header->head.store(0, std::memory_order_relaxed);
+    m_header->tail.store(0, std::memory_order_relaxed);
+    m_header->consumerWaiting.store(0, std::memory_order_relaxed);
+}
+
+bool ShmRing::tryPush(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length) {
+    size_t total = prefixLength + length;
+    if (total > maxMessageSize()) {
+        return false;
+    }
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    if (head - m_header->tail.load(std::memory_order_acquire) >= m_header->slotCount) {
+        return false;
+    }
+    uint8_t* target = slot(head);
+    uint32_t length32 = static_cast<uint32_t>(total);
+    std::memcpy(target, &length32, sizeof(length32));
+    if (prefixLength) {
+        std::memcpy(target + sizeof(length32), prefix, prefixLength);
+    }
+    if (length) {
+        std::memcpy(target + sizeof(length32) + prefixLength, data, length);
+    }
+    m_header->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool ShmRing::tryPop(std::vector<uint8_t>& out) {
+    uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    if (tail == m_header->head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const uint8_t* source = slot(tail);
+    uint32_t length;
+    std::memcpy(&length, source, sizeof(length));
+    if (length > maxMessageSize()) {
+        length = 0;  // corrupt slot; deliver an empty message rather than overrun
+    }
+    out.assign(source + sizeof(length), source + sizeof(length) + length);
+    m_header->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+size_t ShmRing::depth() const {
+    return static_cast<size_t>(m_header->head.load(std::memory_order_acquire) -
+                               m_header->tail.load(std::memory_order_acquire));
+}
+
+ShmChannel::ShmChannel(Role role, std::string name)
+    : m_role(role), m_name(std::move(name)), m_shmName("/hub-" + m_name) {
+    std::string server = "/tmp/hub-" + m_name + ".server.sock";
+    std::string client = "/tmp/hub-" + m_name + ".client.sock";
+    m_localSocketPath = role == Role::Server ? server : client;
+    m_peerSocketPath = role == Role::Server ? client : server;
+}
+
+ShmChannel::~ShmChannel() {
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        ::unlink(m_localSocketPath.c_str());
+    }
+    if (m_mapping) {
+        ::munmap(m_mapping, m_mappingSize);
+    }
+    if (m_role == Role::Server) {
+        ::shm_unlink(m_shmName.c_str());
+    }
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::create(const std::string& name, uint32_t slotSize, uint32_t slotCount) {
+    std::unique_ptr<ShmChannel> channel(new ShmChannel(Role::Server, name));
+    if (!channel->map(true, alignUp(slotSize, 64), slotCount) || !channel->openSockets()) {
+        return nullptr;
+    }
+    return channel;
+}
+
+std::unique_ptr<ShmChannel> ShmChannel::connect(const std::string& name) {
+    std::unique_ptr<ShmChannel> channel(new ShmChannel(Role::Client, name));
+    if (!channel->map(false, 0, 0) || !channel->openSockets()) {
+        return nullptr;
+    }
+    return channel;
+}
+
+bool ShmChannel::map(bool create, uint32_t slotSize, uint32_t slotCount) {
+    int fd;
+    if (create) {
+        ::shm_unlink(m_shmName.c_str());
+        fd = ::shm_open(m_shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    } else {
+        fd = ::shm_open(m_shmName.c_str(), O_RDWR, 0);
+    }
+    if (fd < 0) {
+        HUB_LOG_ERROR("shm_open {} failed: {}", m_shmName, std::strerror(errno));
+        return false;
+    }
+
+    size_t ringsOffset = alignUp(sizeof(SegmentHeader), 64);
+    if (create) {
+        m_mappingSize = ringsOffset + 2 * ShmRing::bytesFor(slotSize, slotCount);
+        if (::ftruncate(fd, static_cast<off_t>(m_mappingSize)) != 0) {
+            HUB_LOG_ERROR("ftruncate {} failed: {}", m_shmName, std::strerror(errno));
+            ::close(fd);
+            return false;
+        }
+    } else {
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < ringsOffset) {
+            ::close(fd);
+            return false;
+        }
+        m_mappingSize = static_cast<size_t>(info.st_size);
+    }
+
+    m_mapping = ::mmap(nullptr, m_mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m_mapping == MAP_FAILED) {
+        m_mapping = nullptr;
+        HUB_LOG_ERROR("mmap {} failed: {}", m_shmName, std::strerror(errno));
+        return false;
+    }
+
+    auto* segment = static_cast<SegmentHeader*>(m_mapping);
+    if (create) {
+        segment->slotSize = slotSize;
+        segment->slotCount = slotCount;
+    } else if (segment->magic != kSegmentMagic ||
+               m_mappingSize < ringsOffset + 2 * ShmRing::bytesFor(segment->slotSize, segment->slotCount)) {
+        HUB_LOG_ERROR("Shared memory segment {} is not a hub channel", m_shmName);
+        return false;
+    }
+
+    size_t ringBytes = ShmRing::bytesFor(segment->slotSize, segment->slotCount);
+    auto* base = static_cast<uint8_t*>(m_mapping) + ringsOffset;
+    ShmRing requests(reinterpret_cast<ShmRingHeader*>(base), base + ringHeaderBytes());
+    ShmRing responses(reinterpret_cast<ShmRingHeader*>(base + ringBytes), base + ringBytes + ringHeaderBytes());
+    if (create) {
+        new (requests.header()) ShmRingHeader();
+        new (responses.header()) ShmRingHeader();
+        requests.initialize(segment->slotSize, segment->slotCount);
+        responses.initialize(segment->slotSize, segment->slotCount);
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = kSegmentMagic;
+    }
+    m_inbound = m_role == Role::Server ? requests : responses;
+    m_outbound = m_role == Role::Server ? responses : requests;
+    return true;
+}
+
+bool ShmChannel::openSockets() {
+    m_socket = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (m_socket < 0) {
+        return false;
+    }
+    ::unlink(m_localSocketPath.c_str());
+    sockaddr_un address = socketAddress(m_localSocketPath);
+    if (::bind(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        HUB_LOG_ERROR("Cannot bind doorbell socket {}: {}", m_localSocketPath, std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void ShmChannel::ringDoorbell() {
+    // Pairs with the fence in receive(): either the consumer sees our new
+    // head before sleeping, or we see its waiting flag here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto& waiting = m_outbound.header()->consumerWaiting;
+    if (waiting.load(std::memory_order_relaxed) && waiting.exchange(0)) {
+        sendDoorbell(m_socket, m_peerSocketPath);
+    }
+}
+
+bool ShmChannel::trySend(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length) {
+    if (!m_outbound.tryPush(prefix, prefixLength, data, length)) {
+        return false;
+    }
+    ringDoorbell();
+    return true;
+}
+
+bool ShmChannel::send(const uint8_t* prefix, size_t prefixLength, const uint8_t* data, size_t length,
+                      int timeoutMs) {
+    if (prefixLength + length > m_outbound.maxMessageSize()) {
+        return false;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!m_outbound.tryPush(prefix, prefixLength, data, length)) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    ringDoorbell();
+    return true;
+}
+
+void ShmChannel::interrupt() {
+    sendDoorbell(m_socket, m_localSocketPath);
+}
+
+bool ShmChannel::receive(std::vector<uint8_t>& message, int timeoutMs) {
+    for (int i = 0; i < kSpinIterations; ++i) {
+        if (m_inbound.tryPop(message)) {
+            return true;
+        }
+    }
+
+    auto& waiting = m_inbound.header()->consumerWaiting;
+    waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_inbound.tryPop(message)) {
+        waiting.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    pollfd descriptor{m_socket, POLLIN, 0};
+    int ready = ::poll(&descriptor, 1, timeoutMs);
+    waiting.store(0, std::memory_order_relaxed);
+    if (ready > 0) {
+        char drain[64];
+        while (::recv(m_socket, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+        }
+    }
+    // A doorbell, timeout or interrupt() all end the wait; callers loop.
+    return m_inbound.tryPop(message);
+}
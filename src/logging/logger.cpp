@@ -0,0 +1,244 @@
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+
+namespace {
+
+struct LoggerMetrics {
+    Gauge& ringOccupancy = MetricsRegistry::instance().gauge("log_ring_occupancy");
+    Gauge& rings = MetricsRegistry::instance().gauge("log_rings");
+};
+
+LoggerMetrics& loggerMetrics() {
+    static LoggerMetrics metrics;
+    return metrics;
+}
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+        default: return "OFF";
+    }
+}
+
+void appendArg(const LogRecord& record, const LogRecord::Arg& arg, std::string& line) {
+    char buffer[32];
+    int length = 0;
+    switch (arg.type) {
+        case LogRecord::ArgType::Int:
+            length = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(arg.i));
+            break;
+        case LogRecord::ArgType::UInt:
+            length = std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(arg.u));
+            break;
+        case LogRecord::ArgType::Double:
+            length = std::snprintf(buffer, sizeof(buffer), "%g", arg.d);
+            break;
+        case LogRecord::ArgType::Bool:
+            line += arg.u ? "true" : "false";
+            return;
+        case LogRecord::ArgType::Text:
+            line.append(record.text + arg.textOffset, arg.textLength);
+            return;
+    }
+    line.append(buffer, static_cast<size_t>(length));
+}
+
+}  // namespace
+
+LogRecord* LogRing::beginWrite() {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == kCapacity) {
+        return nullptr;
+    }
+    return &m_records[head & (kCapacity - 1)];
+}
+
+void LogRing::commitWrite() {
+    m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+bool LogRing::read(LogRecord& out) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    out = m_records[tail & (kCapacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+Logger& Logger::instance() {
+    static Logger* logger = [] {
+        auto* created = new Logger();
+        std::atexit([] { Logger::instance().flush(); });
+        return created;
+    }();
+    return *logger;
+}
+
+Logger::Logger() : m_sink(stderr) {
+    std::thread(&Logger::writerLoop, this).detach();
+}
+
+void Logger::setSink(std::FILE* sink) {
+    flush();
+    m_sink.store(sink ? sink : stderr);
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(m_flushMutex);
+    uint64_t target = ++m_flushRequests;
+    m_flushCv.notify_all();
+    m_flushCv.wait(lock, [&] { return m_flushCompleted >= target; });
+}
+
+uint64_t Logger::droppedCount() const {
+    std::lock_guard<std::mutex> lock(m_ringsMutex);
+    uint64_t total = m_retiredDropped;
+    for (const auto& ring : m_rings) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t Logger::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+LogRing& Logger::threadRing() {
+    struct Handle {
+        std::shared_ptr<LogRing> ring;
+        ~Handle() {
+            if (ring) {
+                ring->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+    thread_local Handle handle;
+    if (!handle.ring) {
+        handle.ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        m_rings.push_back(handle.ring);
+    }
+    return *handle.ring;
+}
+
+void Logger::captureText(LogRecord& record, const char* text, size_t length) {
+    LogRecord::Arg& arg = record.args[record.argCount++];
+    size_t room = LogRecord::kTextBytes - record.textUsed;
+    if (length > room) {
+        length = room;
+        record.truncated = true;
+    }
+    arg.type = LogRecord::ArgType::Text;
+    arg.textOffset = record.textUsed;
+    arg.textLength = static_cast<uint8_t>(length);
+    std::memcpy(record.text + record.textUsed, text, length);
+    record.textUsed = static_cast<uint8_t>(record.textUsed + length);
+}
+
+void Logger::render(const LogRecord& record, std::string& line) {
+    std::time_t seconds = static_cast<std::time_t>(record.timestampNs / 1000000000ull);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+    char stamp[40];
+    size_t stampLength = std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &local);
+    std::snprintf(stamp + stampLength, sizeof(stamp) - stampLength, ".%06llu",
+                  static_cast<unsigned long long>((record.timestampNs / 1000) % 1000000));
+
+    line += '[';
+    line += stamp;
+    line += "] [";
+    line += levelName(record.level);
+    line += "] ";
+
+    size_t next = 0;
+    for (const char* p = record.format; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}' && next < record.argCount) {
+            appendArg(record, record.args[next++], line);
+            ++p;
+        } else {
+            line += *p;
+        }
+    }
+    if (record.truncated) {
+        line += " [truncated]";
+    }
+    line += '\n';
+}
+
+size_t Logger::drainOnce(std::string& line) {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        rings = m_rings;
+    }
+
+    // Sampled by the writer so producers pay nothing for the gauges.
+    size_t occupancy = 0;
+    for (const auto& ring : rings) {
+        occupancy += ring->size();
+    }
+    LoggerMetrics& metrics = loggerMetrics();
+    metrics.ringOccupancy.set(static_cast<int64_t>(occupancy));
+    metrics.rings.set(static_cast<int64_t>(rings.size()));
+
+    size_t written = 0;
+    LogRecord record;
+    for (const auto& ring : rings) {
+        bool retired = ring->retired.load(std::memory_order_acquire);
+        while (ring->read(record)) {
+            render(record, line);
+            ++written;
+        }
+        if (retired) {
+            // The owning thread has exited and its ring is now empty.
+            std::lock_guard<std::mutex> lock(m_ringsMutex);
+            m_retiredDropped += ring->dropped.load(std::memory_order_relaxed);
+            for (auto it = m_rings.begin(); it != m_rings.end(); ++it) {
+                if (*it == ring) {
+                    m_rings.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!line.empty()) {
+        std::FILE* sink = m_sink.load();
+        std::fwrite(line.data(), 1, line.size(), sink);
+        std::fflush(sink);
+        line.clear();
+    }
+    return written;
+}
+
+void Logger::writerLoop() {
+    std::string line;
+    line.reserve(64 * 1024);
+    for (;;) {
+        uint64_t requested;
+        {
+            std::lock_guard<std::mutex> lock(m_flushMutex);
+            requested = m_flushRequests;
+        }
+        while (drainOnce(line) > 0) {
+        }
+        std::unique_lock<std::mutex> lock(m_flushMutex);
+        if (requested > m_flushCompleted) {
+            m_flushCompleted = requested;
+            m_flushCv.notify_all();
+        }
+        m_flushCv.wait_for(lock, std::chrono::milliseconds(5),
+                           [&] { return m_flushRequests > m_flushCompleted; });
+    }
+}
@@ -0,0 +1,143 @@
+#include "business/hub_service.h"
+#include "ipc/hub_ipc.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include "network/http_server.h"
+#include "network/hub_http_api.h"
+#include "network/satellite_hub.h"
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/resource.h>
+
+namespace {
+
+std::atomic<bool> g_running{true};
+
+void handleSignal(int) {
+    g_running.store(false);
+}
+
+struct Options {
+    std::string ipcName = "disaster-relief-hub";
+    std::string metricsPath = "/tmp/disaster_relief_hub.prom";
+    std::string dataDir = "hub-data";
+    std::string httpAddress = "0.0.0.0";
+    uint16_t httpPort = 8080;
+    unsigned reactors = 0;
+    size_t maxClients = 16384;
+    bool offline = false;
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "Usage: %s [--ipc-name NAME] [--metrics-file PATH] [--data-dir PATH]\n"
+                 "          [--http-address ADDR] [--http-port PORT] [--reactors N] [--max-clients N]\n"
+                 "          [--offline]\n"
+                 "  --ipc-name NAME      shared-memory channel name (default disaster-relief-hub)\n"
+                 "  --metrics-file PATH  metrics snapshot for the dashboard\n"
+                 "  --data-dir PATH      market snapshots and write-ahead log (default hub-data)\n"
+                 "  --http-address ADDR  Wi-Fi interface address for PWA clients (default 0.0.0.0)\n"
+                 "  --http-port PORT     PWA API port (default 8080)\n"
+                 "  --reactors N         event loops, default one per core\n"
+                 "  --max-clients N      concurrent client connections (default 16384)\n"
+                 "  --offline            do not bring up the satellite link\n",
+                 program);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ipc-name" && i + 1 < argc) {
+            options.ipcName = argv[++i];
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            options.metricsPath = argv[++i];
+        } else if (arg == "--data-dir" && i + 1 < argc) {
+            options.dataDir = argv[++i];
+        } else if (arg == "--http-address" && i + 1 < argc) {
+            options.httpAddress = argv[++i];
+        } else if (arg == "--http-port" && i + 1 < argc) {
+            options.httpPort = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--reactors" && i + 1 < argc) {
+            options.reactors = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg == "--max-clients" && i + 1 < argc) {
+            options.maxClients = static_cast<size_t>(std::atoll(argv[++i]));
+        } else if (arg == "--offline") {
+            options.offline = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each client holds a descriptor; lift the soft limit as far as allowed.
+void raiseFileLimit(size_t wanted) {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < wanted) {
+        limit.rlim_cur = wanted < limit.rlim_max ? wanted : limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    SatelliteHub satellite;
+    bool online = false;
+    if (!options.offline) {
+        online = satellite.initializeSRPT() && satellite.connectToSatellite();
+        if (!online) {
+            HUB_LOG_WARN("Satellite link unavailable; serving the local market only");
+        }
+    }
+
+    HubService service(online ? &satellite : nullptr);
+    if (!service.enableDurability(options.dataDir)) {
+        HUB_LOG_ERROR("Cannot open market data in {}", options.dataDir);
+        Logger::instance().flush();
+        return EXIT_FAILURE;
+    }
+    MetricsExporter exporter(options.metricsPath, std::chrono::seconds(1));
+
+    auto channel = ShmChannel::create(options.ipcName);
+    if (!channel) {
+        HUB_LOG_ERROR("Cannot create IPC channel {}", options.ipcName);
+        Logger::instance().flush();
+        return EXIT_FAILURE;
+    }
+    HubIpcServer ipcServer(service, std::move(channel));
+
+    raiseFileLimit(options.maxClients + 256);
+    HttpServer::Config httpConfig;
+    httpConfig.bindAddress = options.httpAddress;
+    httpConfig.port = options.httpPort;
+    httpConfig.reactors = options.reactors;
+    httpConfig.maxConnections = options.maxClients;
+    HttpServer httpServer(httpConfig, makeHubHttpHandler(service));
+    if (!httpServer.start()) {
+        HUB_LOG_ERROR("Cannot start HTTP server on port {}", options.httpPort);
+        Logger::instance().flush();
+        return EXIT_FAILURE;
+    }
+
+    HUB_LOG_INFO("Hub daemon serving IPC channel {}", options.ipcName);
+    ipcServer.serve(g_running);
+    httpServer.stop();
+    service.checkpoint();
+
+    HUB_LOG_INFO("Hub daemon shutting down");
+    Logger::instance().flush();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "metrics/metrics.h"
+#include "logging/logger.h"
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < kSubBuckets) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int shift = bucket / kSubBuckets - 1;
+    uint64_t sub = static_cast<uint64_t>(bucket % kSubBuckets);
+    uint64_t lower = (kSubBuckets + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+    if (target == 0) {
+        target = 1;
+    }
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += m_buckets[bucket].load(std::memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t bound = bucketUpperBound(bucket);
+            return bound < max() ? bound : max();
+        }
+    }
+    return max();
+}
+
+TraceSpan::~TraceSpan() {
+    auto elapsed = std::chrono::steady_clock::now() - m_start;
+    uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    m_histogram.record(ns);
+    HUB_LOG_TRACE("span {} took {} ns", m_name, ns);
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    // Leaked for the same reason as Logger: metrics may be touched from
+    // static destructors.
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& slot = m_counters[name];
+    if (!slot) {
+        slot = std::make_unique<Counter>();
+    }
+    return *slot;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& slot = m_gauges[name];
+    if (!slot) {
+        slot = std::make_unique<Gauge>();
+    }
+    return *slot;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& slot = m_histograms[name];
+    if (!slot) {
+        slot = std::make_unique<LatencyHistogram>();
+    }
+    return *slot;
+}
+
+std::string MetricsRegistry::renderText() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::ostringstream out;
+    for (const auto& [name, counter] : m_counters) {
+        out << "# TYPE " << name << " counter\n" << name << ' ' << counter->value() << '\n';
+    }
+    for (const auto& [name, gauge] : m_gauges) {
+        out << "# TYPE " << name << " gauge\n" << name << ' ' << gauge->value() << '\n';
+    }
+    for (const auto& [name, histogram] : m_histograms) {
+        out << "# TYPE " << name << " summary\n";
+        for (double q : {0.5, 0.9, 0.99, 0.999}) {
+            out << name << "{quantile=\"" << q << "\"} " << histogram->percentile(q) << '\n';
+        }
+        out << name << "_max " << histogram->max() << '\n';
+        out << name << "_sum " << histogram->sum() << '\n';
+        out << name << "_count " << histogram->count() << '\n';
+    }
+    return out.str();
+}
+
+MetricsExporter::MetricsExporter(std::string path, std::chrono::milliseconds interval)
+    : m_path(std::move(path)), m_interval(interval), m_thread(&MetricsExporter::run, this) {}
+
+MetricsExporter::~MetricsExporter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    m_thread.join();
+    writeNow();
+}
+
+bool MetricsExporter::writeNow() {
+    std::string text = MetricsRegistry::instance().renderText();
+    std::string tmpPath = m_path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "w");
+    if (!file) {
+        HUB_LOG_WARN("Cannot open metrics file {}", tmpPath);
+        return false;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        HUB_LOG_WARN("Failed to write metrics file {}", m_path);
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_cv.wait_for(lock, m_interval, [this] { return m_stopping; })) {
+        lock.unlock();
+        writeNow();
+        lock.lock();
+    }
+}
@@ -0,0 +1,448 @@
+#include "network/federated_hub.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <cstring>
+
+namespace {
+
+struct FederationMetrics {
+    Counter& messages = MetricsRegistry::instance().counter("federation_messages");
+    Counter& frames = MetricsRegistry::instance().counter("federation_frames");
+    Counter& failovers = MetricsRegistry::instance().counter("federation_failovers");
+    Counter& hints = MetricsRegistry::instance().counter("federation_hints");
+    Counter& hintsDropped = MetricsRegistry::instance().counter("federation_hints_dropped");
+};
+
+FederationMetrics& federationMetrics() {
+    static FederationMetrics metrics;
+    return metrics;
+}
+
+bool isWrite(IpcOp op) {
+    return op == IpcOp::CreateListing || op == IpcOp::UpdateListing || op == IpcOp::PlacePreorder ||
+           op == IpcOp::CancelPreorder;
+}
+
+bool isListingWrite(IpcOp op) {
+    return op == IpcOp::CreateListing || op == IpcOp::UpdateListing;
+}
+
+bool readHeader(const std::vector<uint8_t>& message, IpcHeader& header) {
+    if (message.size() < sizeof(IpcHeader)) {
+        return false;
+    }
+    std::memcpy(&header, message.data(), sizeof(header));
+    return true;
+}
+
+}  // namespace
+
+FederatedHub::FederatedHub(NetworkSimulator& network, HubId self, HubService& local,
+                           const std::vector<HubId>& members, Config config)
+    : m_network(network),
+      m_self(self),
+      m_local(local),
+      m_executor(local, nullptr),
+      m_config(config),
+      m_ring(config.virtualNodes) {
+    for (HubId member : members) {
+        m_ring.addNode(member);
+    }
+    m_ring.addNode(m_self);
+    m_network.setReceiver(m_self, [this](HubId from, const std::vector<uint8_t>& frame) { onReceive(from, frame); });
+}
+
+FederatedHub::~FederatedHub() {
+    m_network.setReceiver(m_self, nullptr);
+}
+
+std::vector<FederatedHub::HubId> FederatedHub::ownersOf(const std::string& key) const {
+    return m_ring.preferenceList(key, m_config.replicationFactor);
+}
+
+bool FederatedHub::isSuspected(HubId hub) const {
+    auto it = m_suspectedUntil.find(hub);
+    return it != m_suspectedUntil.end() && m_network.now() < it->second;
+}
+
+void FederatedHub::submit(IpcOp op, const std::string& routingKey, const std::vector<uint8_t>& payload,
+                          ResponseHandler handler) {
+    auto pending = std::make_unique<Pending>();
+    pending->hub = this;
+    pending->requestId = m_nextRequestId++;
+    pending->routingKey = routingKey;
+    pending->owners = ownersOf(routingKey);
+    pending->handler = std::move(handler);
+    pending->timeout.setCallback(&FederatedHub::onTimeout, pending.get());
+
+    IpcHeader header{pending->requestId, static_cast<uint16_t>(op), 0, static_cast<uint32_t>(payload.size())};
+    IpcWriter writer(pending->message);
+    writer.raw(&header, sizeof(header));
+    writer.raw(payload.data(), payload.size());
+
+    Pending& ref = *pending;
+    m_pending.emplace(ref.requestId, std::move(pending));
+    dispatch(ref);
+}
+
+void FederatedHub::dispatch(Pending& pending) {
+    while (pending.attempt < pending.owners.size() && isSuspected(pending.owners[pending.attempt]) &&
+           pending.owners[pending.attempt] != m_self) {
+        ++pending.attempt;
+    }
+    if (pending.attempt >= pending.owners.size()) {
+        complete(pending.requestId, IpcStatus::Failed, {});
+        return;
+    }
+
+    pending.target = pending.owners[pending.attempt];
+    if (pending.target == m_self) {
+        ++m_stats.requestsLocal;
+        std::vector<uint8_t> response;
+        executeAsOwner(pending.routingKey, pending.attempt > 0, pending.message, response);
+        IpcHeader header{};
+        readHeader(response, header);
+        complete(pending.requestId, static_cast<IpcStatus>(header.status),
+                 std::vector<uint8_t>(response.begin() + sizeof(IpcHeader), response.end()));
+        return;
+    }
+
+    ++m_stats.requestsRemote;
+    std::vector<uint8_t> body;
+    IpcWriter writer(body);
+    writer.u16(pending.attempt > 0 ? 1 : 0);
+    writer.str(pending.routingKey);
+    writer.raw(pending.message.data(), pending.message.size());
+    enqueue(pending.target, EntryKind::Request, body);
+    m_network.wheel().schedule(pending.timeout, m_config.requestTimeoutTicks);
+}
+
+void FederatedHub::complete(uint32_t requestId, IpcStatus status, const std::vector<uint8_t>& payload) {
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end()) {
+        return;
+    }
+    ResponseHandler handler = std::move(it->second->handler);
+    m_pending.erase(it);
+    if (handler) {
+        handler(status, payload);
+    }
+}
+
+void FederatedHub::onTimeout(void* context) {
+    auto* pending = static_cast<Pending*>(context);
+    FederatedHub* hub = pending->hub;
+    HUB_LOG_WARN("Federation request {} to hub {} timed out", pending->requestId, pending->target);
+    hub->suspect(pending->target);
+    ++hub->m_stats.failovers;
+    federationMetrics().failovers.add();
+    ++pending->attempt;
+    hub->dispatch(*pending);
+}
+
+void FederatedHub::executeAsOwner(const std::string& routingKey, bool failover, const std::vector<uint8_t>& request,
+                                  std::vector<uint8_t>& response) {
+    IpcHeader requestHeader{};
+    bool parsed = readHeader(request, requestHeader);
+    IpcOp op = static_cast<IpcOp>(requestHeader.op);
+    if (parsed && failover && isListingWrite(op)) {
+        // The primary may already hold the listing and will see it again as
+        // a hint, so a failover write must not create a second one.
+        IpcHeader header{requestHeader.requestId, requestHeader.op, static_cast<uint16_t>(upsertListing(request)), 0};
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+        response.assign(bytes, bytes + sizeof(header));
+    } else {
+        m_executor.handle(request, response);
+    }
+    IpcHeader responseHeader{};
+    if (!parsed || !readHeader(response, responseHeader) || !isWrite(op) ||
+        static_cast<IpcStatus>(responseHeader.status) != IpcStatus::Ok) {
+        return;
+    }
+
+    std::vector<HubId> owners = ownersOf(routingKey);
+    if (failover && !owners.empty() && owners.front() != m_self) {
+        // The requester gave up on the primary; so do we until it speaks.
+        suspect(owners.front());
+    }
+    for (HubId owner : owners) {
+        if (owner != m_self) {
+            replicate(owner, request);
+        }
+    }
+}
+
+void FederatedHub::replicate(HubId owner, const std::vector<uint8_t>& request) {
+    std::map<uint64_t, Unacked>& unacked = m_unacked[owner];
+    if (unacked.size() >= m_config.maxHintsPerHub) {
+        ++m_stats.hintsDropped;
+        federationMetrics().hintsDropped.add();
+        return;
+    }
+    uint64_t sequence = m_nextReplica++;
+    Unacked& replica = unacked[sequence];
+    replica.request = request;
+    if (isSuspected(owner)) {
+        replica.hint = true;
+        ++m_stats.hintsQueued;
+        federationMetrics().hints.add();
+        return;
+    }
+    sendReplica(owner, sequence, replica);
+}
+
+void FederatedHub::sendReplica(HubId owner, uint64_t sequence, Unacked& replica) {
+    std::vector<uint8_t> body;
+    IpcWriter writer(body);
+    writer.u64(sequence);
+    writer.raw(replica.request.data(), replica.request.size());
+    enqueue(owner, EntryKind::Replicate, body);
+    replica.sent = true;
+    replica.sentAt = m_network.now();
+}
+
+// False when the local store refused the write, so the sender keeps it and
+// tries again; malformed writes are acknowledged since a retry can't help.
+bool FederatedHub::applyReplica(const std::vector<uint8_t>& request) {
+    IpcHeader header{};
+    if (!readHeader(request, header)) {
+        return true;
+    }
+    IpcStatus status = IpcStatus::Failed;
+    if (isListingWrite(static_cast<IpcOp>(header.op))) {
+        status = upsertListing(request);
+    } else {
+        std::vector<uint8_t> response;
+        m_executor.handle(request, response);
+        IpcHeader responseHeader{};
+        if (readHeader(response, responseHeader)) {
+            status = static_cast<IpcStatus>(responseHeader.status);
+        }
+    }
+    return status != IpcStatus::Failed;
+}
+
+// Shared by failover, replication and hint replay; `request` holds at least
+// an IpcHeader.
+IpcStatus FederatedHub::upsertListing(const std::vector<uint8_t>& request) {
+    IpcReader reader(request.data() + sizeof(IpcHeader), request.size() - sizeof(IpcHeader));
+    Listing listing;
+    int32_t quantity;
+    if (!reader.str(listing.name) || !reader.i32(quantity) || !reader.f64(listing.price)) {
+        return IpcStatus::BadRequest;
+    }
+    listing.quantity = quantity;
+    if (!HubService::isValid(listing)) {
+        return IpcStatus::BadRequest;
+    }
+    Listing existing;
+    bool ok = m_local.findListing(listing.name, existing)
+                  ? m_local.updateListing(listing.name, listing.quantity, listing.price)
+                  : m_local.createListing(listing);
+    return ok ? IpcStatus::Ok : IpcStatus::Failed;
+}
+
+void FederatedHub::onReceive(HubId from, const std::vector<uint8_t>& frame) {
+    // The whole frame is checked before any of it counts as hearing from
+    // the sender, so garbage never triggers a hint replay.
+    IpcReader reader(frame.data(), frame.size());
+    uint16_t count = 0;
+    std::vector<std::pair<uint16_t, std::vector<uint8_t>>> entries;
+    bool wellFormed = reader.u16(count);
+    for (uint16_t i = 0; wellFormed && i < count; ++i) {
+        uint16_t kind = 0;
+        uint32_t length = 0;
+        wellFormed = reader.u16(kind) && reader.u32(length) && reader.remaining() >= length;
+        if (wellFormed) {
+            const uint8_t* data = frame.data() + (frame.size() - reader.remaining());
+            entries.emplace_back(kind, std::vector<uint8_t>(data, data + length));
+            reader.skip(length);
+        }
+    }
+    if (!wellFormed) {
+        HUB_LOG_WARN("Malformed federation frame from hub {}", from);
+        return;
+    }
+    heardFrom(from);
+
+    std::vector<uint8_t> response;
+    for (const auto& [kind, body] : entries) {
+        switch (static_cast<EntryKind>(kind)) {
+            case EntryKind::Request: {
+                IpcReader requestReader(body.data(), body.size());
+                uint16_t failover = 0;
+                std::string routingKey;
+                if (!requestReader.u16(failover) || !requestReader.str(routingKey)) {
+                    break;
+                }
+                std::vector<uint8_t> request(body.end() - static_cast<long>(requestReader.remaining()), body.end());
+                response.clear();
+                executeAsOwner(routingKey, failover != 0, request, response);
+                enqueue(from, EntryKind::Response, response);
+                break;
+            }
+            case EntryKind::Response: {
+                IpcHeader header{};
+                if (!readHeader(body, header)) {
+                    break;
+                }
+                auto it = m_pending.find(header.requestId);
+                // A late answer from a hub we already failed over from is dropped.
+                if (it == m_pending.end() || it->second->target != from) {
+                    break;
+                }
+                m_network.wheel().cancel(it->second->timeout);
+                complete(header.requestId, static_cast<IpcStatus>(header.status),
+                         std::vector<uint8_t>(body.begin() + sizeof(IpcHeader), body.end()));
+                break;
+            }
+            case EntryKind::Replicate: {
+                IpcReader replicaReader(body.data(), body.size());
+                uint64_t sequence = 0;
+                if (!replicaReader.u64(sequence) ||
+                    !applyReplica(std::vector<uint8_t>(body.begin() + sizeof(sequence), body.end()))) {
+                    break;
+                }
+                std::vector<uint8_t> ack;
+                IpcWriter(ack).u64(sequence);
+                enqueue(from, EntryKind::Ack, ack);
+                break;
+            }
+            case EntryKind::Ack: {
+                IpcReader ackReader(body.data(), body.size());
+                uint64_t sequence = 0;
+                auto owner = m_unacked.find(from);
+                if (!ackReader.u64(sequence) || owner == m_unacked.end()) {
+                    break;
+                }
+                auto it = owner->second.find(sequence);
+                // A write sent twice is acknowledged twice.
+                if (it == owner->second.end()) {
+                    break;
+                }
+                if (it->second.hint) {
+                    ++m_stats.hintsDelivered;
+                }
+                owner->second.erase(it);
+                break;
+            }
+            default:
+                HUB_LOG_WARN("Unknown federation entry {} from hub {}", kind, from);
+                break;
+        }
+    }
+}
+
+void FederatedHub::heardFrom(HubId hub) {
+    if (m_suspectedUntil.erase(hub) > 0) {
+        HUB_LOG_INFO("Hub {} is reachable again", hub);
+    }
+    auto unacked = m_unacked.find(hub);
+    if (unacked == m_unacked.end()) {
+        return;
+    }
+    // Hints go out now; writes already sent get until the request timeout
+    // for their acknowledgement before they are sent again.
+    uint64_t now = m_network.now();
+    for (auto& [sequence, replica] : unacked->second) {
+        if (!replica.sent || now >= replica.sentAt + m_config.requestTimeoutTicks) {
+            sendReplica(hub, sequence, replica);
+        }
+    }
+}
+
+void FederatedHub::suspect(HubId hub) {
+    m_suspectedUntil[hub] = m_network.now() + m_config.suspectTicks;
+}
+
+void FederatedHub::enqueue(HubId peer, EntryKind kind, const std::vector<uint8_t>& body) {
+    Outbox& outbox = m_outboxes[peer];
+    if (outbox.bytes.empty()) {
+        outbox.bytes.resize(sizeof(uint16_t));  // entry count, patched on flush
+    }
+    IpcWriter writer(outbox.bytes);
+    writer.u16(static_cast<uint16_t>(kind));
+    writer.u32(static_cast<uint32_t>(body.size()));
+    writer.raw(body.data(), body.size());
+    ++outbox.entries;
+    ++m_stats.messagesSent;
+    federationMetrics().messages.add();
+
+    if (outbox.bytes.size() >= m_config.maxBatchBytes || outbox.entries == UINT16_MAX) {
+        flushPeer(peer, outbox);
+    } else if (!m_flushTimer.isPending()) {
+        m_network.wheel().schedule(m_flushTimer, m_config.batchTicks);
+    }
+}
+
+void FederatedHub::onFlush(void* context) {
+    static_cast<FederatedHub*>(context)->flushAll();
+}
+
+void FederatedHub::flushAll() {
+    for (auto& entry : m_outboxes) {
+        if (entry.second.entries > 0) {
+            flushPeer(entry.first, entry.second);
+        }
+    }
+}
+
+void FederatedHub::flushPeer(HubId peer, Outbox& outbox) {
+    std::memcpy(outbox.bytes.data(), &outbox.entries, sizeof(outbox.entries));
+    std::vector<uint8_t> frame = std::move(outbox.bytes);
+    outbox.bytes.clear();
+    outbox.entries = 0;
+    ++m_stats.framesSent;
+    federationMetrics().frames.add();
+    if (!m_network.send(m_self, peer, std::move(frame))) {
+        // Lost requests surface as timeouts. Replicated writes stay
+        // unacknowledged and go out again as soon as the peer is heard from.
+        HUB_LOG_DEBUG("Federation peer {} unreachable from {}", peer, m_self);
+        auto unacked = m_unacked.find(peer);
+        if (unacked != m_unacked.end()) {
+            for (auto& entry : unacked->second) {
+                entry.second.sent = false;
+            }
+        }
+    }
+}
+
+void FederatedHub::createListing(const Listing& listing, ResponseHandler handler) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(listing.name);
+    writer.i32(listing.quantity);
+    writer.f64(listing.price);
+    submit(IpcOp::CreateListing, listing.name, payload, std::move(handler));
+}
+
+void FederatedHub::updateListing(const std::string& name, int quantity, double price, ResponseHandler handler) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(name);
+    writer.i32(quantity);
+    writer.f64(price);
+    submit(IpcOp::UpdateListing, name, payload, std::move(handler));
+}
+
+void FederatedHub::getListing(const std::string& name, ResponseHandler handler) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(name);
+    submit(IpcOp::GetListing, name, payload, std::move(handler));
+}
+
+void FederatedHub::placePreorder(const Preorder& preorder, ResponseHandler handler) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(preorder.itemName);
+    writer.i32(preorder.quantity);
+    submit(IpcOp::PlacePreorder, preorder.itemName, payload, std::move(handler));
+}
+
+void FederatedHub::cancelPreorder(const std::string& itemName, ResponseHandler handler) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str(itemName);
+    submit(IpcOp::CancelPreorder, itemName, payload, std::move(handler));
+}
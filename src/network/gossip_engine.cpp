@@ -0,0 +1,259 @@
+#include "network/gossip_engine.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr uint8_t kFrameVersion = 1;
+// version, sender, batch sequence, record count; authenticated in clear
+constexpr size_t kFrameHeaderBytes = 1 + 4 + 8 + 2;
+constexpr size_t kRecordFixedBytes = 8 + 4 + 8 + 1 + 2;
+
+struct GossipMetrics {
+    Counter& batchesSent = MetricsRegistry::instance().counter("gossip_batches_sent");
+    Counter& batchesRejected = MetricsRegistry::instance().counter("gossip_batches_rejected");
+    Counter& recordsRelayed = MetricsRegistry::instance().counter("gossip_records_relayed");
+    Counter& duplicates = MetricsRegistry::instance().counter("gossip_duplicates");
+    Counter& rateLimited = MetricsRegistry::instance().counter("gossip_rate_limited");
+};
+
+GossipMetrics& gossipMetrics() {
+    static GossipMetrics metrics;
+    return metrics;
+}
+
+template <typename T>
+void put(std::vector<uint8_t>& out, T value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T get(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+EncryptionModule::Nonce batchNonce(uint32_t sender, uint64_t batch) {
+    EncryptionModule::Nonce nonce{};
+    std::memcpy(nonce.data(), &sender, 4);
+    std::memcpy(nonce.data() + 4, &batch, 8);
+    return nonce;
+}
+
+}  // namespace
+
+GossipEngine::GossipEngine(NetworkSimulator& network, NodeId self, Config config)
+    : m_network(network),
+      m_self(self),
+      m_config(config),
+      m_seen(config.bloomBits, config.bloomHashes),
+      m_lastRotation(network.now()) {
+    EncryptionModule::initialize();
+    EncryptionModule::randomBytes(&m_nextBatch, sizeof(m_nextBatch));
+    m_network.setReceiver(m_self, [this](NodeId from, const std::vector<uint8_t>& frame) { onReceive(from, frame); });
+}
+
+GossipEngine::~GossipEngine() {
+    m_network.setReceiver(m_self, nullptr);
+}
+
+void GossipEngine::setPeerKey(NodeId peer, const EncryptionModule::Key& key) {
+    auto it = m_peers.find(peer);
+    if (it != m_peers.end()) {
+        it->second.key = key;
+        return;
+    }
+    m_peers.emplace(peer, Peer{key, m_config.peerBurst, m_network.now(), {}});
+    m_peerIds.push_back(peer);
+}
+
+uint64_t GossipEngine::announce(const std::vector<uint8_t>& key) {
+    Record record{(static_cast<uint64_t>(m_self) << 32) | m_nextSequence++, m_self, m_network.now(), 0, key};
+    rotateIfDue(record.timestamp);
+    m_seen.insert(record.messageId);
+    relay(record, m_self);
+    return record.messageId;
+}
+
+void GossipEngine::onReceive(NodeId from, const std::vector<uint8_t>& frame) {
+    GossipMetrics& metrics = gossipMetrics();
+    auto reject = [&] {
+        ++m_stats.batchesRejected;
+        metrics.batchesRejected.add();
+    };
+    auto peer = m_peers.find(from);
+    if (peer == m_peers.end() || frame.size() < kFrameHeaderBytes || frame[0] != kFrameVersion ||
+        get<uint32_t>(&frame[1]) != from) {
+        reject();
+        return;
+    }
+    uint64_t batch = get<uint64_t>(&frame[5]);
+    uint16_t count = get<uint16_t>(&frame[13]);
+    if (!EncryptionModule::open(peer->second.key, batchNonce(from, batch), frame.data(), kFrameHeaderBytes,
+                                frame.data() + kFrameHeaderBytes, frame.size() - kFrameHeaderBytes, m_plain)) {
+        reject();
+        return;
+    }
+
+    // Parse everything before acting so a malformed batch is dropped whole.
+    std::vector<Record> records;
+    records.reserve(count);
+    size_t offset = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        if (m_plain.size() - offset < kRecordFixedBytes) {
+            reject();
+            return;
+        }
+        const uint8_t* data = m_plain.data() + offset;
+        Record record;
+        record.messageId = get<uint64_t>(data);
+        record.origin = get<uint32_t>(data + 8);
+        record.timestamp = get<uint64_t>(data + 12);
+        record.hops = data[20];
+        uint16_t keyLength = get<uint16_t>(data + 21);
+        offset += kRecordFixedBytes;
+        if (m_plain.size() - offset < keyLength) {
+            reject();
+            return;
+        }
+        record.key.assign(m_plain.begin() + static_cast<long>(offset),
+                          m_plain.begin() + static_cast<long>(offset + keyLength));
+        offset += keyLength;
+        records.push_back(std::move(record));
+    }
+    for (auto& record : records) {
+        accept(std::move(record), from);
+    }
+}
+
+// A rotation drops the generation that ended at the previous rotation, so
+// ids first seen up to and including that tick may be gone. Nothing can be
+// first seen before it is stamped, so later timestamps are still covered.
+// The first rotation only drops the empty initial generation.
+void GossipEngine::rotateIfDue(uint64_t now) {
+    if (now - m_lastRotation >= m_config.dedupWindowTicks || m_seen.generationSize() >= m_seen.capacity()) {
+        m_seen.rotate();
+        if (m_rotated) {
+            m_forgottenBefore = m_lastRotation + 1;
+        }
+        m_rotated = true;
+        m_lastRotation = now;
+    }
+}
+
+void GossipEngine::accept(Record record, NodeId from) {
+    uint64_t now = m_network.now();
+    rotateIfDue(now);
+    if (record.timestamp + m_config.dedupWindowTicks < now || record.timestamp < m_forgottenBefore) {
+        // Older than anything the filter is guaranteed to remember.
+        ++m_stats.expired;
+        return;
+    }
+    if (!m_seen.insertIfAbsent(record.messageId)) {
+        ++m_stats.duplicates;
+        gossipMetrics().duplicates.add();
+        return;
+    }
+
+    ++m_stats.received;
+    if (m_handler) {
+        m_handler(KeyAnnouncement{record.messageId, record.origin, record.timestamp, record.key}, record.hops);
+    }
+    if (record.hops < m_config.hopLimit) {
+        relay(record, from);
+    }
+}
+
+void GossipEngine::relay(const Record& record, NodeId exclude) {
+    m_candidates.clear();
+    for (NodeId peer : m_peerIds) {
+        if (peer != exclude && peer != record.origin) {
+            m_candidates.push_back(peer);
+        }
+    }
+    size_t fanout = std::min(m_config.fanout, m_candidates.size());
+    std::mt19937_64& random = m_network.random();
+    for (size_t i = 0; i < fanout; ++i) {
+        // Partial Fisher-Yates: the first `fanout` slots become the sample.
+        size_t pick = i + std::uniform_int_distribution<size_t>(0, m_candidates.size() - 1 - i)(random);
+        std::swap(m_candidates[i], m_candidates[pick]);
+
+        Peer& peer = m_peers.find(m_candidates[i])->second;
+        if (peer.outbox.size() >= m_config.maxQueuedPerPeer) {
+            ++m_stats.rateLimited;
+            gossipMetrics().rateLimited.add();
+            continue;
+        }
+        Record copy = record;
+        copy.hops = static_cast<uint8_t>(record.hops + 1);
+        peer.outbox.push_back(std::move(copy));
+    }
+    if (!m_flushTimer.isPending()) {
+        m_network.wheel().schedule(m_flushTimer, m_config.batchTicks);
+    }
+}
+
+void GossipEngine::onFlush(void* context) {
+    static_cast<GossipEngine*>(context)->flush();
+}
+
+void GossipEngine::flush() {
+    uint64_t now = m_network.now();
+    bool backlog = false;
+    for (NodeId peerId : m_peerIds) {
+        Peer& peer = m_peers.find(peerId)->second;
+        if (peer.outbox.empty()) {
+            continue;
+        }
+        peer.tokens = std::min(m_config.peerBurst,
+                               peer.tokens + m_config.peerRatePerTick * static_cast<double>(now - peer.lastRefill));
+        peer.lastRefill = now;
+        size_t allowed = static_cast<size_t>(std::floor(peer.tokens));
+        size_t count = std::min({allowed, peer.outbox.size(), m_config.maxBatchRecords});
+        if (count > 0 && sendBatch(peerId, peer, count)) {
+            peer.tokens -= static_cast<double>(count);
+        }
+        backlog = backlog || !peer.outbox.empty();
+    }
+    if (backlog) {
+        m_network.wheel().schedule(m_flushTimer, m_config.batchTicks);
+    }
+}
+
+bool GossipEngine::sendBatch(NodeId peerId, Peer& peer, size_t count) {
+    m_plain.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const Record& record = peer.outbox[i];
+        put<uint64_t>(m_plain, record.messageId);
+        put<uint32_t>(m_plain, record.origin);
+        put<uint64_t>(m_plain, record.timestamp);
+        put<uint8_t>(m_plain, record.hops);
+        put<uint16_t>(m_plain, static_cast<uint16_t>(record.key.size()));
+        m_plain.insert(m_plain.end(), record.key.begin(), record.key.end());
+    }
+    peer.outbox.erase(peer.outbox.begin(), peer.outbox.begin() + static_cast<long>(count));
+
+    uint64_t batch = m_nextBatch++;
+    std::vector<uint8_t> frame;
+    frame.reserve(kFrameHeaderBytes + m_plain.size() + EncryptionModule::kTagBytes);
+    put<uint8_t>(frame, kFrameVersion);
+    put<uint32_t>(frame, m_self);
+    put<uint64_t>(frame, batch);
+    put<uint16_t>(frame, static_cast<uint16_t>(count));
+    EncryptionModule::seal(peer.key, batchNonce(m_self, batch), frame.data(), kFrameHeaderBytes, m_plain.data(),
+                           m_plain.size(), frame);
+    if (!m_network.send(m_self, peerId, std::move(frame))) {
+        HUB_LOG_DEBUG("Gossip peer {} unreachable from {}", peerId, m_self);
+        return false;
+    }
+    ++m_stats.batchesSent;
+    m_stats.relayed += count;
+    gossipMetrics().batchesSent.add();
+    gossipMetrics().recordsRelayed.add(count);
+    return true;
+}
@@ -0,0 +1,643 @@
+#include "network/http_server.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kListenerToken = ~uint64_t(0) - 1;
+constexpr uint64_t kWakeToken = ~uint64_t(0);
+constexpr size_t kMaxWriteBacklog = 256 * 1024;
+constexpr int kMaxEvents = 256;
+
+struct HttpMetrics {
+    LatencyHistogram& requestLatency = MetricsRegistry::instance().histogram("http_request_ns");
+    Counter& requests = MetricsRegistry::instance().counter("http_requests");
+    Counter& rejectedConnections = MetricsRegistry::instance().counter("http_rejected_connections");
+    Counter& deferredRequests = MetricsRegistry::instance().counter("http_deferred_requests");
+    Gauge& connections = MetricsRegistry::instance().gauge("http_connections");
+};
+
+HttpMetrics& httpMetrics() {
+    static HttpMetrics metrics;
+    return metrics;
+}
+
+const char* statusText(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 503: return "Service Unavailable";
+        default: return status < 500 ? "Client Error" : "Internal Server Error";
+    }
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] + 32) : a[i];
+        char y = b[i] >= 'A' && b[i] <= 'Z' ? static_cast<char>(b[i] + 32) : b[i];
+        if (x != y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) {
+        s.remove_prefix(1);
+    }
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) {
+        s.remove_suffix(1);
+    }
+    return s;
+}
+
+enum class ParseResult { Complete, Incomplete, Bad, TooLarge };
+
+// Parses one request from the front of `data`; on Complete, `consumed` is
+// its total length including the body.
+ParseResult parseRequest(std::string_view data, size_t capacity, HttpRequest& request, size_t& consumed) {
+    size_t headerEnd = data.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        return data.size() >= capacity ? ParseResult::TooLarge : ParseResult::Incomplete;
+    }
+
+    size_t lineEnd = data.find("\r\n");
+    std::string_view line = data.substr(0, lineEnd);
+    size_t firstSpace = line.find(' ');
+    size_t secondSpace = line.find(' ', firstSpace + 1);
+    if (firstSpace == std::string_view::npos || secondSpace == std::string_view::npos) {
+        return ParseResult::Bad;
+    }
+    request.method = line.substr(0, firstSpace);
+    request.path = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+    std::string_view version = line.substr(secondSpace + 1);
+    request.keepAlive = version == "HTTP/1.1";
+
+    size_t contentLength = 0;
+    bool haveLength = false;
+    size_t position = lineEnd + 2;
+    while (position < headerEnd) {
+        size_t end = data.find("\r\n", position);
+        std::string_view header = data.substr(position, end - position);
+        position = end + 2;
+        size_t colon = header.find(':');
+        if (colon == std::string_view::npos) {
+            return ParseResult::Bad;
+        }
+        std::string_view name = header.substr(0, colon);
+        std::string_view value = trim(header.substr(colon + 1));
+        if (equalsIgnoreCase(name, "content-length")) {
+            size_t length = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9' || length > capacity) {
+                    return ParseResult::Bad;
+                }
+                length = length * 10 + static_cast<size_t>(c - '0');
+            }
+            // Framing must be unambiguous, or a proxy in front could see a
+            // different request boundary than we do.
+            if (value.empty() || (haveLength && length != contentLength)) {
+                return ParseResult::Bad;
+            }
+            contentLength = length;
+            haveLength = true;
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            // Chunked bodies aren't supported; guessing a length would turn
+            // the chunk data into a smuggled pipelined request.
+            return ParseResult::Bad;
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (equalsIgnoreCase(value, "close")) {
+                request.keepAlive = false;
+            } else if (equalsIgnoreCase(value, "keep-alive")) {
+                request.keepAlive = true;
+            }
+        }
+    }
+
+    size_t total = headerEnd + 4 + contentLength;
+    if (total > capacity) {
+        return ParseResult::TooLarge;
+    }
+    if (data.size() < total) {
+        return ParseResult::Incomplete;
+    }
+    request.body = data.substr(headerEnd + 4, contentLength);
+    consumed = total;
+    return ParseResult::Complete;
+}
+
+// Runs a handler's deferred work, turning an escaping exception into a 500.
+void runDeferred(HttpResponse& response) {
+    std::function<void(HttpResponse&)> work = std::move(response.deferred);
+    response.deferred = nullptr;
+    try {
+        work(response);
+    } catch (const std::exception& e) {
+        HUB_LOG_ERROR("Deferred HTTP handler threw: {}", e.what());
+        response = HttpResponse{500, "application/json", "{\"error\":\"internal\"}", "", nullptr};
+    }
+}
+
+void appendResponse(std::string& out, const HttpResponse& response, bool keepAlive) {
+    out += "HTTP/1.1 ";
+    out += std::to_string(response.status);
+    out += ' ';
+    out += statusText(response.status);
+    out += "\r\nContent-Type: ";
+    out += response.contentType;
+    out += "\r\nContent-Length: ";
+    out += std::to_string(response.body.size());
+    out += "\r\n";
+    out += response.headers;
+    out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    out += response.body;
+}
+
+}  // namespace
+
+class HttpServer::Reactor {
+public:
+    Reactor(HttpServer& server, size_t maxConnections)
+        : m_server(server),
+          m_config(server.m_config),
+          m_handler(server.m_handler),
+          m_arena(new char[maxConnections * m_config.readBufferSize]),
+          m_connections(maxConnections) {
+        m_freeList.reserve(maxConnections);
+        for (size_t i = maxConnections; i-- > 0;) {
+            Connection& connection = m_connections[i];
+            connection.reactor = this;
+            connection.index = static_cast<uint32_t>(i);
+            connection.readBuffer = m_arena.get() + i * m_config.readBufferSize;
+            connection.idleTimer.setCallback(&Reactor::onIdle, &connection);
+            m_freeList.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    ~Reactor() {
+        for (auto& connection : m_connections) {
+            if (connection.fd >= 0) {
+                ::close(connection.fd);
+            }
+        }
+        for (int fd : {m_listener, m_epoll, m_wake}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    bool listen(uint16_t port, uint16_t& boundPort) {
+        m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+        m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_epoll < 0 || m_wake < 0 || m_listener < 0) {
+            return false;
+        }
+        int one = 1;
+        ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (::inet_pton(AF_INET, m_config.bindAddress.c_str(), &address.sin_addr) != 1 ||
+            ::bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(m_listener, SOMAXCONN) != 0) {
+            HUB_LOG_ERROR("Cannot listen on {}:{}: {}", m_config.bindAddress, port, std::strerror(errno));
+            return false;
+        }
+        socklen_t length = sizeof(address);
+        ::getsockname(m_listener, reinterpret_cast<sockaddr*>(&address), &length);
+        boundPort = ntohs(address.sin_port);
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = kListenerToken;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listener, &event);
+        event.data.u64 = kWakeToken;
+        ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &event);
+        return true;
+    }
+
+    void run() {
+        auto started = std::chrono::steady_clock::now();
+        epoll_event events[kMaxEvents];
+        while (m_running.load(std::memory_order_relaxed)) {
+            int count = ::epoll_wait(m_epoll, events, kMaxEvents, 1000);
+            for (int i = 0; i < count; ++i) {
+                uint64_t token = events[i].data.u64;
+                if (token == kListenerToken) {
+                    acceptAll();
+                } else if (token == kWakeToken) {
+                    uint64_t value;
+                    ssize_t drained = ::read(m_wake, &value, sizeof(value));
+                    (void)drained;
+                    completeDeferred();
+                } else {
+                    onEvent(token, events[i].events);
+                }
+            }
+            auto elapsed = std::chrono::steady_clock::now() - started;
+            m_wheel.advanceTo(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count()));
+        }
+    }
+
+    void stop() {
+        m_running.store(false);
+        uint64_t one = 1;
+        ssize_t written = ::write(m_wake, &one, sizeof(one));
+        (void)written;
+    }
+
+    size_t activeConnections() const { return m_active.load(std::memory_order_relaxed); }
+
+    // Called on a worker thread once a deferred response is ready.
+    void complete(DeferredJob job) {
+        {
+            std::lock_guard<std::mutex> lock(m_completedMutex);
+            m_completed.push_back(std::move(job));
+        }
+        uint64_t one = 1;
+        ssize_t written = ::write(m_wake, &one, sizeof(one));
+        (void)written;
+    }
+
+private:
+    struct Connection {
+        Reactor* reactor = nullptr;
+        uint32_t index = 0;
+        uint32_t generation = 0;
+        int fd = -1;
+        char* readBuffer = nullptr;
+        size_t readLength = 0;
+        std::string writeBuffer;
+        size_t writeOffset = 0;
+        bool closeAfterWrite = false;
+        bool peerClosed = false;
+        bool awaiting = false;  // a deferred response is still being produced
+        uint32_t interest = 0;
+        TimerWheel::Timer idleTimer;
+    };
+
+    static uint64_t tokenFor(const Connection& connection) {
+        return (uint64_t(connection.generation) << 32) | connection.index;
+    }
+
+    static void onIdle(void* context) {
+        auto* connection = static_cast<Connection*>(context);
+        connection->reactor->closeConnection(*connection);
+    }
+
+    void acceptAll() {
+        HttpMetrics& metrics = httpMetrics();
+        for (;;) {
+            int fd = ::accept4(m_listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                return;  // EAGAIN, or EMFILE: retry on the next readiness event
+            }
+            if (m_freeList.empty()) {
+                metrics.rejectedConnections.add();
+                ::close(fd);
+                continue;
+            }
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+            Connection& connection = m_connections[m_freeList.back()];
+            m_freeList.pop_back();
+            connection.fd = fd;
+            connection.readLength = 0;
+            connection.writeBuffer.clear();
+            connection.writeOffset = 0;
+            connection.closeAfterWrite = false;
+            connection.peerClosed = false;
+            connection.awaiting = false;
+            connection.interest = EPOLLIN | EPOLLRDHUP;
+
+            epoll_event event{};
+            event.events = connection.interest;
+            event.data.u64 = tokenFor(connection);
+            ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event);
+            m_wheel.schedule(connection.idleTimer, m_config.idleTimeoutSeconds);
+            m_active.fetch_add(1, std::memory_order_relaxed);
+            metrics.connections.add();
+        }
+    }
+
+    void onEvent(uint64_t token, uint32_t events) {
+        Connection& connection = m_connections[static_cast<uint32_t>(token)];
+        if (connection.fd < 0 || connection.generation != static_cast<uint32_t>(token >> 32)) {
+            return;  // closed earlier in this batch
+        }
+        if (events & (EPOLLERR | EPOLLHUP)) {
+            closeConnection(connection);
+            return;
+        }
+        if (events & EPOLLOUT) {
+            if (!flush(connection)) {
+                return;
+            }
+        }
+        if (events & (EPOLLIN | EPOLLRDHUP)) {
+            if (!readAvailable(connection)) {
+                return;
+            }
+        }
+        // Requests parked behind a write backlog can proceed once it drains.
+        processRequests(connection);
+        if (!flush(connection)) {
+            return;
+        }
+        updateInterest(connection);
+    }
+
+    // Returns false if the connection was closed.
+    bool readAvailable(Connection& connection) {
+        while (connection.readLength < m_config.readBufferSize) {
+            ssize_t n = ::recv(connection.fd, connection.readBuffer + connection.readLength,
+                               m_config.readBufferSize - connection.readLength, 0);
+            if (n > 0) {
+                connection.readLength += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n == 0) {
+                // Half-close: answer what was already received, then close.
+                connection.peerClosed = true;
+                break;
+            }
+            closeConnection(connection);
+            return false;
+        }
+        m_wheel.schedule(connection.idleTimer, m_config.idleTimeoutSeconds);
+        return true;
+    }
+
+    void processRequests(Connection& connection) {
+        HttpMetrics& metrics = httpMetrics();
+        while (!connection.closeAfterWrite && !connection.awaiting && connection.readLength > 0 &&
+               connection.writeBuffer.size() - connection.writeOffset < kMaxWriteBacklog) {
+            HttpRequest request;
+            size_t consumed = 0;
+            ParseResult result = parseRequest(std::string_view(connection.readBuffer, connection.readLength),
+                                              m_config.readBufferSize, request, consumed);
+            if (result == ParseResult::Incomplete) {
+                break;
+            }
+
+            HttpResponse response;
+            if (result == ParseResult::Complete) {
+                TraceSpan span("http_request", metrics.requestLatency);
+                try {
+                    m_handler(request, response);
+                } catch (const std::exception& e) {
+                    HUB_LOG_ERROR("HTTP handler threw: {}", e.what());
+                    response = HttpResponse{500, "application/json", "{\"error\":\"internal\"}", "", nullptr};
+                }
+                metrics.requests.add();
+            } else {
+                response.status = result == ParseResult::TooLarge ? 413 : 400;
+                response.body = "{\"error\":\"malformed request\"}";
+                request.keepAlive = false;
+                consumed = connection.readLength;
+            }
+            bool keepAlive = request.keepAlive;
+            std::memmove(connection.readBuffer, connection.readBuffer + consumed, connection.readLength - consumed);
+            connection.readLength -= consumed;
+
+            if (response.deferred) {
+                metrics.deferredRequests.add();
+                if (!m_server.m_workers.empty()) {
+                    connection.awaiting = true;
+                    m_server.submit(DeferredJob{this, tokenFor(connection), keepAlive, std::move(response)});
+                    break;
+                }
+                runDeferred(response);
+            }
+            appendResponse(connection.writeBuffer, response, keepAlive);
+            connection.closeAfterWrite = !keepAlive;
+        }
+    }
+
+    // Writes out responses finished by the workers, then resumes reading
+    // the connections they were holding up.
+    void completeDeferred() {
+        std::vector<DeferredJob> completed;
+        {
+            std::lock_guard<std::mutex> lock(m_completedMutex);
+            completed.swap(m_completed);
+        }
+        for (DeferredJob& job : completed) {
+            Connection& connection = m_connections[static_cast<uint32_t>(job.token)];
+            if (connection.fd < 0 || connection.generation != static_cast<uint32_t>(job.token >> 32)) {
+                continue;  // closed while the work ran
+            }
+            connection.awaiting = false;
+            appendResponse(connection.writeBuffer, job.response, job.keepAlive);
+            connection.closeAfterWrite = !job.keepAlive;
+            processRequests(connection);
+            if (flush(connection)) {
+                updateInterest(connection);
+            }
+        }
+    }
+
+    bool flush(Connection& connection) {
+        while (connection.writeOffset < connection.writeBuffer.size()) {
+            ssize_t n = ::send(connection.fd, connection.writeBuffer.data() + connection.writeOffset,
+                               connection.writeBuffer.size() - connection.writeOffset, MSG_NOSIGNAL);
+            if (n > 0) {
+                connection.writeOffset += static_cast<size_t>(n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            }
+            closeConnection(connection);
+            return false;
+        }
+        connection.writeBuffer.clear();
+        connection.writeOffset = 0;
+        if ((connection.closeAfterWrite || connection.peerClosed) && !connection.awaiting) {
+            closeConnection(connection);
+            return false;
+        }
+        return true;
+    }
+
+    void updateInterest(Connection& connection) {
+        size_t pending = connection.writeBuffer.size() - connection.writeOffset;
+        uint32_t interest = 0;
+        if (pending > 0) {
+            interest |= EPOLLOUT;
+        }
+        // Stop reading while a large backlog drains so a pipelining client
+        // cannot grow the write buffer without bound.
+        if (pending < kMaxWriteBacklog && !connection.closeAfterWrite && !connection.peerClosed &&
+            !connection.awaiting) {
+            interest |= EPOLLIN | EPOLLRDHUP;
+        }
+        if (interest != connection.interest) {
+            connection.interest = interest;
+            epoll_event event{};
+            event.events = interest;
+            event.data.u64 = tokenFor(connection);
+            ::epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &event);
+        }
+    }
+
+    void closeConnection(Connection& connection) {
+        if (connection.fd < 0) {
+            return;
+        }
+        ::close(connection.fd);  // also removes it from the epoll set
+        connection.fd = -1;
+        ++connection.generation;
+        m_wheel.cancel(connection.idleTimer);
+        if (connection.writeBuffer.capacity() > kMaxWriteBacklog) {
+            std::string().swap(connection.writeBuffer);
+        }
+        m_freeList.push_back(connection.index);
+        m_active.fetch_sub(1, std::memory_order_relaxed);
+        httpMetrics().connections.sub();
+    }
+
+    HttpServer& m_server;
+    const Config& m_config;
+    const HttpHandler& m_handler;
+    std::unique_ptr<char[]> m_arena;
+    std::vector<Connection> m_connections;
+    std::vector<uint32_t> m_freeList;
+    TimerWheel m_wheel;
+    int m_epoll = -1;
+    int m_listener = -1;
+    int m_wake = -1;
+    std::atomic<bool> m_running{true};
+    std::atomic<size_t> m_active{0};
+
+    std::mutex m_completedMutex;
+    std::vector<DeferredJob> m_completed;
+};
+
+HttpServer::HttpServer(Config config, HttpHandler handler)
+    : m_config(std::move(config)), m_handler(std::move(handler)) {}
+
+HttpServer::~HttpServer() {
+    stop();
+}
+
+bool HttpServer::start() {
+    unsigned reactors = m_config.reactors ? m_config.reactors : std::thread::hardware_concurrency();
+    if (reactors == 0) {
+        reactors = 1;
+    }
+    size_t perReactor = (m_config.maxConnections + reactors - 1) / reactors;
+
+    uint16_t port = m_config.port;
+    for (unsigned i = 0; i < reactors; ++i) {
+        auto reactor = std::make_unique<Reactor>(*this, perReactor);
+        if (!reactor->listen(port, port)) {
+            m_reactors.clear();
+            return false;
+        }
+        m_reactors.push_back(std::move(reactor));
+    }
+    m_boundPort = port;
+
+    m_workersStopping = false;
+    for (unsigned i = 0; i < m_config.workers; ++i) {
+        m_workers.emplace_back(&HttpServer::workerLoop, this);
+    }
+    for (auto& reactor : m_reactors) {
+        m_threads.emplace_back([r = reactor.get()] { r->run(); });
+    }
+    HUB_LOG_INFO("HTTP server listening on {}:{} with {} reactors", m_config.bindAddress, m_boundPort, reactors);
+    return true;
+}
+
+void HttpServer::stop() {
+    // Workers go first: they hand finished responses to the reactors.
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_workersStopping = true;
+        m_jobs.clear();
+    }
+    m_jobReady.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+
+    for (auto& reactor : m_reactors) {
+        reactor->stop();
+    }
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    m_reactors.clear();
+}
+
+void HttpServer::submit(DeferredJob job) {
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_jobReady.notify_one();
+}
+
+void HttpServer::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+    for (;;) {
+        m_jobReady.wait(lock, [this] { return !m_jobs.empty() || m_workersStopping; });
+        if (m_workersStopping) {
+            return;
+        }
+        DeferredJob job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+        runDeferred(job.response);
+        job.reactor->complete(std::move(job));
+        lock.lock();
+    }
+}
+
+size_t HttpServer::activeConnections() const {
+    size_t total = 0;
+    for (const auto& reactor : m_reactors) {
+        total += reactor->activeConnections();
+    }
+    return total;
+}
@@ -0,0 +1,414 @@
+#include "network/hub_http_api.h"
+#include "business/hub_service.h"
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+void appendJsonString(std::string& out, const std::string& value) {
+    out += '"';
+    for (char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+// Locates the value following "key": in a flat JSON object. Enough for the
+// fixed request shapes above without pulling in a JSON library.
+size_t findJsonValue(std::string_view body, std::string_view key) {
+    std::string quoted = "\"" + std::string(key) + "\"";
+    size_t position = body.find(quoted);
+    if (position == std::string_view::npos) {
+        return std::string_view::npos;
+    }
+    position = body.find(':', position + quoted.size());
+    if (position == std::string_view::npos) {
+        return std::string_view::npos;
+    }
+    ++position;
+    while (position < body.size() && (body[position] == ' ' || body[position] == '\t' || body[position] == '\n')) {
+        ++position;
+    }
+    return position < body.size() ? position : std::string_view::npos;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Four hex digits at body[position]; -1 if malformed or truncated.
+long hexQuad(std::string_view body, size_t position) {
+    if (position + 4 > body.size()) {
+        return -1;
+    }
+    long value = 0;
+    for (size_t i = position; i < position + 4; ++i) {
+        int digit = hexDigit(body[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+void appendUtf8(std::string& out, long codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xc0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xe0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (codePoint & 0x3f));
+    }
+}
+
+// False on an unterminated string, an unknown escape, a lone surrogate or
+// \u0000, so clients get a 400 rather than a silently mangled name.
+bool jsonString(std::string_view body, std::string_view key, std::string& out) {
+    size_t position = findJsonValue(body, key);
+    if (position == std::string_view::npos || body[position] != '"') {
+        return false;
+    }
+    out.clear();
+    for (size_t i = position + 1; i < body.size(); ++i) {
+        char c = body[i];
+        if (c == '"') {
+            return true;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++i == body.size()) {
+            return false;
+        }
+        switch (body[i]) {
+            case '"': out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '/': out += '/'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                long codePoint = hexQuad(body, i + 1);
+                i += 4;
+                if (codePoint >= 0xd800 && codePoint < 0xdc00) {
+                    long low = i + 2 < body.size() && body[i + 1] == '\\' && body[i + 2] == 'u'
+                                   ? hexQuad(body, i + 3)
+                                   : -1;
+                    if (low < 0xdc00 || low >= 0xe000) {
+                        return false;
+                    }
+                    codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+                    i += 6;
+                } else if (codePoint >= 0xdc00 && codePoint < 0xe000) {
+                    return false;
+                }
+                if (codePoint <= 0) {
+                    return false;
+                }
+                appendUtf8(out, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+bool jsonNumber(std::string_view body, std::string_view key, double& out) {
+    size_t position = findJsonValue(body, key);
+    if (position == std::string_view::npos) {
+        return false;
+    }
+    std::string number(body.substr(position, 32));
+    char* end = nullptr;
+    out = std::strtod(number.c_str(), &end);
+    return end != number.c_str();
+}
+
+// Finite, integral and within [minimum, INT_MAX]; anything else would make
+// the cast to int undefined.
+bool jsonInt(std::string_view body, std::string_view key, int minimum, int& out) {
+    double value = 0;
+    if (!jsonNumber(body, key, value) || !std::isfinite(value) || value != std::floor(value) ||
+        value < minimum || value > INT_MAX) {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Decodes a path segment, where '+' is literal. False on a malformed or NUL
+// escape.
+bool urlDecode(std::string_view encoded, std::string& decoded) {
+    decoded.clear();
+    decoded.reserve(encoded.size());
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        if (encoded[i] == '%') {
+            int high = i + 2 < encoded.size() ? hexDigit(encoded[i + 1]) : -1;
+            int low = high >= 0 ? hexDigit(encoded[i + 2]) : -1;
+            if (low < 0 || (high == 0 && low == 0)) {
+                return false;
+            }
+            decoded += static_cast<char>(high * 16 + low);
+            i += 2;
+        } else {
+            decoded += encoded[i];
+        }
+    }
+    return true;
+}
+
+// Value of `key` in the query string, if present.
+bool queryParameter(std::string_view path, std::string_view key, std::string_view& value) {
+    size_t question = path.find('?');
+    if (question == std::string_view::npos) {
+        return false;
+    }
+    std::string_view query = path.substr(question + 1);
+    while (!query.empty()) {
+        size_t amp = query.find('&');
+        std::string_view pair = query.substr(0, amp);
+        size_t equals = pair.find('=');
+        if (pair.substr(0, equals) == key) {
+            value = equals == std::string_view::npos ? std::string_view() : pair.substr(equals + 1);
+            return true;
+        }
+        query = amp == std::string_view::npos ? std::string_view() : query.substr(amp + 1);
+    }
+    return false;
+}
+
+// Unsigned decimal query parameter; `out` keeps its default when absent.
+bool queryNumber(std::string_view path, std::string_view key, size_t maximum, size_t& out) {
+    std::string_view text;
+    if (!queryParameter(path, key, text)) {
+        return true;
+    }
+    if (text.empty() || text.size() > 9) {
+        return false;
+    }
+    size_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    if (value > maximum) {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+// GET lists are paged like the IPC protocol: ?offset=&limit=, with the
+// full count in X-Total-Count, so one request never serializes the whole
+// market on a reactor thread.
+constexpr size_t kDefaultPageSize = 100;
+constexpr size_t kMaxPageSize = 1000;
+
+bool pageRequest(std::string_view path, size_t& offset, size_t& limit) {
+    offset = 0;
+    limit = kDefaultPageSize;
+    return queryNumber(path, "offset", SIZE_MAX, offset) && queryNumber(path, "limit", kMaxPageSize, limit);
+}
+
+void setTotal(HttpResponse& response, size_t total) {
+    response.headers += "X-Total-Count: " + std::to_string(total) + "\r\n";
+}
+
+void error(HttpResponse& response, int status, const char* message) {
+    response.status = status;
+    response.body = std::string("{\"error\":\"") + message + "\"}";
+}
+
+void listListings(HubService& service, size_t offset, size_t limit, HttpResponse& response) {
+    size_t total = 0;
+    std::vector<Listing> listings = service.getListings(offset, limit, total);
+    setTotal(response, total);
+    std::string& out = response.body;
+    out = "[";
+    bool first = true;
+    for (const Listing& listing : listings) {
+        out += first ? "{\"name\":" : ",{\"name\":";
+        first = false;
+        appendJsonString(out, listing.name);
+        out += ",\"quantity\":" + std::to_string(listing.quantity);
+        char price[32];
+        std::snprintf(price, sizeof(price), "%.15g", listing.price);
+        out += ",\"price\":";
+        out += price;
+        out += '}';
+    }
+    out += ']';
+}
+
+void listPreorders(HubService& service, size_t offset, size_t limit, HttpResponse& response) {
+    size_t total = 0;
+    std::vector<Preorder> preorders = service.getPreorders(offset, limit, total);
+    setTotal(response, total);
+    std::string& out = response.body;
+    out = "[";
+    bool first = true;
+    for (const Preorder& preorder : preorders) {
+        out += first ? "{\"itemName\":" : ",{\"itemName\":";
+        first = false;
+        appendJsonString(out, preorder.itemName);
+        out += ",\"quantity\":" + std::to_string(preorder.quantity) + '}';
+    }
+    out += ']';
+}
+
+}  // namespace
+
+// Reads run on the reactor; mutations wait for the journal's fdatasync, so
+// they are deferred to the server's workers once the request is validated.
+HttpHandler makeHubHttpHandler(HubService& service) {
+    return [&service](const HttpRequest& request, HttpResponse& response) {
+        std::string_view path = request.path.substr(0, request.path.find('?'));
+        std::string_view method = request.method;
+
+        if (path == "/health") {
+            response.body = "{\"status\":\"ok\"}";
+            return;
+        }
+
+        if (path == "/listings") {
+            if (method == "GET") {
+                size_t offset, limit;
+                if (!pageRequest(request.path, offset, limit)) {
+                    return error(response, 400, "bad offset or limit");
+                }
+                listListings(service, offset, limit, response);
+            } else if (method == "POST") {
+                Listing listing;
+                if (!jsonString(request.body, "name", listing.name) ||
+                    !jsonInt(request.body, "quantity", 0, listing.quantity) ||
+                    !jsonNumber(request.body, "price", listing.price) || !HubService::isValid(listing)) {
+                    return error(response, 400, "expected name, quantity and price");
+                }
+                response.deferred = [&service, listing](HttpResponse& deferred) {
+                    if (!service.createListing(listing)) {
+                        return error(deferred, 409, "listing rejected");
+                    }
+                    deferred.status = 201;
+                    deferred.body = "{}";
+                };
+            } else {
+                error(response, 405, "method not allowed");
+            }
+            return;
+        }
+
+        constexpr std::string_view kListingPrefix = "/listings/";
+        if (path.substr(0, kListingPrefix.size()) == kListingPrefix) {
+            if (method != "PUT") {
+                return error(response, 405, "method not allowed");
+            }
+            int quantity = 0;
+            double price = 0;
+            if (!jsonInt(request.body, "quantity", 0, quantity) || !jsonNumber(request.body, "price", price) ||
+                !HubService::isValid(Listing{"", quantity, price})) {
+                return error(response, 400, "expected quantity and price");
+            }
+            std::string name;
+            if (!urlDecode(path.substr(kListingPrefix.size()), name)) {
+                return error(response, 400, "bad escape in path");
+            }
+            response.deferred = [&service, name, quantity, price](HttpResponse& deferred) {
+                if (!service.updateListing(name, quantity, price)) {
+                    return error(deferred, 404, "no such listing");
+                }
+                deferred.body = "{}";
+            };
+            return;
+        }
+
+        if (path == "/preorders") {
+            if (method == "GET") {
+                size_t offset, limit;
+                if (!pageRequest(request.path, offset, limit)) {
+                    return error(response, 400, "bad offset or limit");
+                }
+                listPreorders(service, offset, limit, response);
+            } else if (method == "POST") {
+                Preorder preorder;
+                if (!jsonString(request.body, "itemName", preorder.itemName) ||
+                    !jsonInt(request.body, "quantity", 1, preorder.quantity) || !HubService::isValid(preorder)) {
+                    return error(response, 400, "expected itemName and quantity");
+                }
+                response.deferred = [&service, preorder](HttpResponse& deferred) {
+                    if (!service.placePreorder(preorder)) {
+                        return error(deferred, 409, "preorder rejected");
+                    }
+                    deferred.status = 201;
+                    deferred.body = "{}";
+                };
+            } else {
+                error(response, 405, "method not allowed");
+            }
+            return;
+        }
+
+        constexpr std::string_view kPreorderPrefix = "/preorders/";
+        if (path.substr(0, kPreorderPrefix.size()) == kPreorderPrefix) {
+            if (method != "DELETE") {
+                return error(response, 405, "method not allowed");
+            }
+            std::string itemName;
+            if (!urlDecode(path.substr(kPreorderPrefix.size()), itemName)) {
+                return error(response, 400, "bad escape in path");
+            }
+            response.deferred = [&service, itemName](HttpResponse& deferred) {
+                if (!service.cancelPreorder(itemName)) {
+                    return error(deferred, 404, "no such preorder");
+                }
+                deferred.status = 204;
+            };
+            return;
+        }
+
+        error(response, 404, "not found");
+    };
+}
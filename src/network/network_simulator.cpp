@@ -0,0 +1,142 @@
+#include "network/network_simulator.h"
+#include <algorithm>
+
+NetworkSimulator::NetworkSimulator(uint64_t seed) : m_random(seed) {}
+
+NetworkSimulator::NodeId NetworkSimulator::addNode() {
+    m_nodes.emplace_back();
+    return static_cast<NodeId>(m_nodes.size() - 1);
+}
+
+void NetworkSimulator::setReceiver(NodeId node, Receiver receiver) {
+    m_nodes[node].receiver = std::move(receiver);
+}
+
+void NetworkSimulator::connect(NodeId a, NodeId b, const LinkProfile& profile) {
+    if (a == b) {
+        return;
+    }
+    setLink(a, b, profile);
+    setLink(b, a, profile);
+}
+
+void NetworkSimulator::disconnect(NodeId a, NodeId b) {
+    removeLink(a, b);
+    removeLink(b, a);
+}
+
+void NetworkSimulator::setLink(NodeId from, NodeId to, const LinkProfile& profile) {
+    Node& node = m_nodes[from];
+    for (auto& link : node.links) {
+        if (link.peer == to) {
+            link.profile = profile;
+            return;
+        }
+    }
+    node.links.push_back(Link{to, profile});
+    node.neighbors.push_back(to);
+}
+
+void NetworkSimulator::removeLink(NodeId from, NodeId to) {
+    Node& node = m_nodes[from];
+    node.links.erase(std::remove_if(node.links.begin(), node.links.end(),
+                                    [to](const Link& link) { return link.peer == to; }),
+                     node.links.end());
+    node.neighbors.erase(std::remove(node.neighbors.begin(), node.neighbors.end(), to), node.neighbors.end());
+}
+
+const NetworkSimulator::Link* NetworkSimulator::findLink(NodeId from, NodeId to) const {
+    for (const auto& link : m_nodes[from].links) {
+        if (link.peer == to) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+void NetworkSimulator::connectRandomMesh(size_t degree, const LinkProfile& profile) {
+    size_t count = m_nodes.size();
+    if (count < 2) {
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        connect(static_cast<NodeId>(i), static_cast<NodeId>((i + 1) % count), profile);
+    }
+    std::uniform_int_distribution<NodeId> pick(0, static_cast<NodeId>(count - 1));
+    for (size_t i = 0; i < count; ++i) {
+        NodeId node = static_cast<NodeId>(i);
+        // Each node opens degree/2 links and accepts about as many.
+        for (size_t extra = 2; extra < degree; extra += 2) {
+            connect(node, pick(m_random), profile);
+        }
+    }
+}
+
+void NetworkSimulator::setNodeUp(NodeId node, bool up) {
+    m_nodes[node].up = up;
+}
+
+bool NetworkSimulator::send(NodeId from, NodeId to, std::vector<uint8_t> payload) {
+    const Link* link = findLink(from, to);
+    if (!link || !m_nodes[from].up) {
+        return false;
+    }
+    ++m_stats.sent;
+    ++m_nodes[from].sent;
+    m_stats.bytes += payload.size();
+    if (link->profile.lossRate > 0.0 &&
+        std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < link->profile.lossRate) {
+        ++m_stats.dropped;
+        return true;
+    }
+
+    Delivery* delivery = m_freeDeliveries;
+    if (delivery) {
+        m_freeDeliveries = delivery->nextFree;
+    } else {
+        m_deliveries.emplace_back();
+        delivery = &m_deliveries.back();
+        delivery->network = this;
+        delivery->timer.setCallback(&NetworkSimulator::onDeliver, delivery);
+    }
+    delivery->from = from;
+    delivery->to = to;
+    delivery->payload = std::move(payload);
+
+    uint64_t delay = link->profile.latencyTicks;
+    if (link->profile.jitterTicks > 0) {
+        delay += std::uniform_int_distribution<uint32_t>(0, link->profile.jitterTicks)(m_random);
+    }
+    m_wheel.schedule(delivery->timer, delay);
+    return true;
+}
+
+void NetworkSimulator::onDeliver(void* context) {
+    auto* delivery = static_cast<Delivery*>(context);
+    NetworkSimulator* network = delivery->network;
+    Node& target = network->m_nodes[delivery->to];
+    // The link may have gone away or the peer died while in flight.
+    if (!target.up || !network->findLink(delivery->from, delivery->to)) {
+        ++network->m_stats.dropped;
+    } else {
+        ++network->m_stats.delivered;
+        if (target.receiver) {
+            target.receiver(delivery->from, delivery->payload);
+        }
+    }
+    delivery->payload.clear();
+    delivery->nextFree = network->m_freeDeliveries;
+    network->m_freeDeliveries = delivery;
+}
+
+uint64_t NetworkSimulator::runUntilIdle(uint64_t maxTicks) {
+    uint64_t start = m_wheel.now();
+    while (m_wheel.pending() > 0 && m_wheel.now() - start < maxTicks) {
+        m_wheel.advance(1);
+    }
+    return m_wheel.now() - start;
+}
+
+void NetworkSimulator::runFor(uint64_t ticks) {
+    m_wheel.advanceTo(m_wheel.now() + ticks);
+}
@@ -1,109 +1,151 @@
 #include "network/satellite_hub.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
 #include "srpt_satellite.h"
-#include <iostream>
+
+namespace {
+
+struct SatelliteMetrics {
+    LatencyHistogram& sendLatency = MetricsRegistry::instance().histogram("satellite_send_ns");
+    LatencyHistogram& receiveLatency = MetricsRegistry::instance().histogram("satellite_receive_ns");
+    Counter& bytesSent = MetricsRegistry::instance().counter("satellite_bytes_sent");
+    Counter& bytesReceived = MetricsRegistry::instance().counter("satellite_bytes_received");
+    Counter& sendFailures = MetricsRegistry::instance().counter("satellite_send_failures");
+    Gauge& sendsInFlight = MetricsRegistry::instance().gauge("satellite_sends_in_flight");
+    Gauge& sendBytesInFlight = MetricsRegistry::instance().gauge("satellite_send_bytes_in_flight");
+};
+
+SatelliteMetrics& satelliteMetrics() {
+    static SatelliteMetrics metrics;
+    return metrics;
+}
+
+}  // namespace
 
 SatelliteHub::SatelliteHub() : m_session(nullptr) {
-    std::cout << "SatelliteHub constructor called" << std::endl;
+    HUB_LOG_DEBUG("SatelliteHub constructor called");
 }
 
 SatelliteHub::~SatelliteHub() {
-    std::cout << "SatelliteHub destructor called" << std::endl;
+    HUB_LOG_DEBUG("SatelliteHub destructor called");
     if (m_session) {
         m_session->Disconnect();
     }
 }
 
 bool SatelliteHub::initializeSRPT() {
-    std::cout << "Initializing SRPT protocol..." << std::endl;
+    HUB_LOG_INFO("Initializing SRPT protocol...");
     try {
         SRPT::Satellite::SatelliteConfig config;
         config.setProvider(SRPT::Satellite::Provider::STARLINK);
         m_session = SRPT::Satellite::CreateSatelliteSession(config);
         if (m_session) {
-            std::cout << "SRPT initialized successfully" << std::endl;
+            HUB_LOG_INFO("SRPT initialized successfully");
             return true;
         } else {
-            std::cerr << "Failed to create SatelliteSession" << std::endl;
+            HUB_LOG_ERROR("Failed to create SatelliteSession");
             return false;
         }
     } catch (const std::exception& e) {
-        std::cerr << "Exception during SRPT initialization: " << e.what() << std::endl;
+        HUB_LOG_ERROR("Exception during SRPT initialization: {}", e.what());
         return false;
     }
 }
 
 bool SatelliteHub::connectToSatellite() {
-    std::cout << "Connecting to satellite..." << std::endl;
+    HUB_LOG_INFO("Connecting to satellite...");
     if (!m_session) {
-        std::cerr << "Cannot connect: SatelliteSession is null" << std::endl;
+        HUB_LOG_ERROR("Cannot connect: SatelliteSession is null");
         return false;
     }
     try {
         bool connected = m_session->Connect("starlink-1");
         if (connected) {
-            std::cout << "Connected to satellite successfully" << std::endl;
+            HUB_LOG_INFO("Connected to satellite successfully");
         } else {
-            std::cerr << "Failed to connect to satellite" << std::endl;
+            HUB_LOG_ERROR("Failed to connect to satellite");
         }
         return connected;
     } catch (const std::exception& e) {
-        std::cerr << "Exception during satellite connection: " << e.what() << std::endl;
+        HUB_LOG_ERROR("Exception during satellite connection: {}", e.what());
         return false;
     }
 }
 
 bool SatelliteHub::sendData(const std::string& data) {
     if (!m_session) {
-        std::cerr << "Cannot send data: Not connected to satellite" << std::endl;
+        HUB_LOG_ERROR("Cannot send data: Not connected to satellite");
         return false;
     }
-    std::cout << "Sending data: " << data << std::endl;
+    // Only the size is logged; payloads can be megabytes.
+    HUB_LOG_DEBUG("Sending {} bytes", data.size());
+    SatelliteMetrics& metrics = satelliteMetrics();
+    TraceSpan span("satellite_send", metrics.sendLatency);
+    // Sends block on the link, so callers waiting in sendData are the send
+    // queue; track its depth in both sends and bytes.
+    int64_t bytes = static_cast<int64_t>(data.size());
+    metrics.sendsInFlight.add();
+    metrics.sendBytesInFlight.add(bytes);
+    struct InFlight {
+        SatelliteMetrics& metrics;
+        int64_t bytes;
+        ~InFlight() {
+            metrics.sendsInFlight.sub();
+            metrics.sendBytesInFlight.sub(bytes);
+        }
+    } inFlight{metrics, bytes};
     try {
         auto stream = m_session->CreateSatelliteStream();
         if (!stream) {
-            std::cerr << "Failed to create satellite stream" << std::endl;
+            HUB_LOG_ERROR("Failed to create satellite stream");
             return false;
         }
         SRPT::ByteVector byteData(data.begin(), data.end());
         bool sent = stream->Write(byteData);
         if (sent) {
-            std::cout << "Data sent successfully" << std::endl;
+            metrics.bytesSent.add(data.size());
+            HUB_LOG_DEBUG("Sent {} bytes successfully", data.size());
         } else {
-            std::cerr << "Failed to send data" << std::endl;
+            metrics.sendFailures.add();
+            HUB_LOG_ERROR("Failed to send {} bytes", data.size());
         }
         return sent;
     } catch (const std::exception& e) {
-        std::cerr << "Exception during data sending: " << e.what() << std::endl;
+        metrics.sendFailures.add();
+        HUB_LOG_ERROR("Exception during data sending: {}", e.what());
         return false;
     }
 }
 
 bool SatelliteHub::receiveData(std::string& data) {
     if (!m_session) {
-        std::cerr << "Cannot receive data: Not connected to satellite" << std::endl;
+        HUB_LOG_ERROR("Cannot receive data: Not connected to satellite");
         return false;
     }
+    SatelliteMetrics& metrics = satelliteMetrics();
+    TraceSpan span("satellite_receive", metrics.receiveLatency);
     try {
         auto stream = m_session->CreateSatelliteStream();
         if (!stream) {
-            std::cerr << "Failed to create satellite stream" << std::endl;
+            HUB_LOG_ERROR("Failed to create satellite stream");
             return false;
         }
         SRPT::ByteVector byteData;
         if (stream->Read(byteData)) {
             if (byteData.empty()) {
-                std::cout << "Received empty data" << std::endl;
+                HUB_LOG_DEBUG("Received empty data");
                 return false;  // Return false for empty reads
             }
             data = std::string(byteData.begin(), byteData.end());
-            std::cout << "Received data: " << data << std::endl;
+            metrics.bytesReceived.add(data.size());
+            HUB_LOG_DEBUG("Received {} bytes", data.size());
             return true;
         } else {
-            std::cerr << "Failed to receive data" << std::endl;
+            HUB_LOG_WARN("Failed to receive data");
             return false;
         }
     } catch (const std::exception& e) {
-        std::cerr << "Exception during data receiving: " << e.what() << std::endl;
+        HUB_LOG_ERROR("Exception during data receiving: {}", e.what());
         return false;
     }
 }
@@ -0,0 +1,492 @@
+#include "storage/market_store.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kSnapshotMagic = 0x3150414E53425548ull;  // "HUBSNAP1"
+constexpr uint32_t kSnapshotVersion = 1;
+constexpr char kSnapshotPrefix[] = "snapshot-";
+constexpr size_t kWriteBufferBytes = 1 << 20;
+
+struct SnapshotHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t bodyCrc;
+    uint64_t lsn;
+    uint64_t listingCount;
+    uint64_t preorderCount;
+};
+
+enum class JournalOp : uint8_t {
+    CreateListing = 1,
+    UpdateListing = 2,
+    PlacePreorder = 3,
+    CancelPreorder = 4,
+};
+
+struct StoreMetrics {
+    LatencyHistogram& snapshotWrite = MetricsRegistry::instance().histogram("snapshot_write_ns");
+    Counter& snapshots = MetricsRegistry::instance().counter("snapshots_written");
+    Gauge& snapshotLsn = MetricsRegistry::instance().gauge("snapshot_lsn");
+};
+
+StoreMetrics& storeMetrics() {
+    static StoreMetrics metrics;
+    return metrics;
+}
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+    void u8(uint8_t v) { m_out.push_back(v); }
+    void i32(int32_t v) { raw(&v, sizeof(v)); }
+    void f64(double v) { raw(&v, sizeof(v)); }
+    void str(const std::string& s) {
+        uint32_t length = static_cast<uint32_t>(s.size());
+        raw(&length, sizeof(length));
+        raw(s.data(), s.size());
+    }
+
+private:
+    void raw(const void* data, size_t length) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        m_out.insert(m_out.end(), bytes, bytes + length);
+    }
+
+    std::vector<uint8_t>& m_out;
+};
+
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t length) : m_data(data), m_end(data + length) {}
+
+    bool ok() const { return m_ok; }
+    bool done() const { return m_data == m_end; }
+
+    uint8_t u8() {
+        uint8_t v = 0;
+        raw(&v, sizeof(v));
+        return v;
+    }
+    int32_t i32() {
+        int32_t v = 0;
+        raw(&v, sizeof(v));
+        return v;
+    }
+    double f64() {
+        double v = 0;
+        raw(&v, sizeof(v));
+        return v;
+    }
+    std::string str() {
+        uint32_t length = 0;
+        raw(&length, sizeof(length));
+        if (!m_ok || static_cast<size_t>(m_end - m_data) < length) {
+            m_ok = false;
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char*>(m_data), length);
+        m_data += length;
+        return s;
+    }
+
+private:
+    void raw(void* out, size_t length) {
+        if (!m_ok || static_cast<size_t>(m_end - m_data) < length) {
+            m_ok = false;
+            return;
+        }
+        std::memcpy(out, m_data, length);
+        m_data += length;
+    }
+
+    const uint8_t* m_data;
+    const uint8_t* m_end;
+    bool m_ok = true;
+};
+
+std::string snapshotName(uint64_t lsn) {
+    char name[40];
+    std::snprintf(name, sizeof(name), "%s%016" PRIx64, kSnapshotPrefix, lsn);
+    return name;
+}
+
+void syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Lists snapshot LSNs in ascending order and removes half-written files.
+std::vector<uint64_t> listSnapshots(const std::string& directory) {
+    std::vector<uint64_t> snapshots;
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        return snapshots;
+    }
+    size_t prefixLength = sizeof(kSnapshotPrefix) - 1;
+    while (dirent* entry = ::readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, kSnapshotPrefix, prefixLength) != 0) {
+            continue;
+        }
+        size_t length = std::strlen(name);
+        if (length != prefixLength + 16) {
+            ::unlink((directory + "/" + name).c_str());
+            continue;
+        }
+        char* end = nullptr;
+        uint64_t lsn = std::strtoull(name + prefixLength, &end, 16);
+        if (end && *end == '\0') {
+            snapshots.push_back(lsn);
+        }
+    }
+    ::closedir(dir);
+    std::sort(snapshots.begin(), snapshots.end());
+    return snapshots;
+}
+
+// Maps the snapshot read-only and decodes it into temporaries, touching the
+// interfaces only once the whole file has checked out, so a bad file leaves
+// them empty for the next candidate.
+bool loadSnapshot(const std::string& path, BusinessInterface& business, RecipientInterface& recipient,
+                  uint64_t& lsn) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const uint8_t* data = static_cast<const uint8_t*>(mapping);
+    SnapshotHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    const uint8_t* body = data + sizeof(header);
+    size_t bodyLength = size - sizeof(header);
+    bool ok = header.magic == kSnapshotMagic && header.version == kSnapshotVersion &&
+              crc32(body, bodyLength) == header.bodyCrc;
+    std::vector<Listing> listings;
+    std::vector<Preorder> preorders;
+    if (ok) {
+        ByteReader reader(body, bodyLength);
+        for (uint64_t i = 0; i < header.listingCount && reader.ok(); ++i) {
+            Listing listing;
+            listing.name = reader.str();
+            listing.quantity = reader.i32();
+            listing.price = reader.f64();
+            listings.push_back(std::move(listing));
+        }
+        for (uint64_t i = 0; i < header.preorderCount && reader.ok(); ++i) {
+            Preorder preorder;
+            preorder.itemName = reader.str();
+            preorder.quantity = reader.i32();
+            preorders.push_back(std::move(preorder));
+        }
+        ok = reader.ok() && reader.done();
+    }
+    ::munmap(mapping, size);
+    if (!ok) {
+        return false;
+    }
+    for (const Listing& listing : listings) {
+        business.createListing(listing);
+    }
+    for (const Preorder& preorder : preorders) {
+        recipient.placePreorder(preorder);
+    }
+    lsn = header.lsn;
+    return true;
+}
+
+bool applyRecord(const uint8_t* payload, size_t length, BusinessInterface& business,
+                 RecipientInterface& recipient) {
+    ByteReader reader(payload, length);
+    switch (static_cast<JournalOp>(reader.u8())) {
+    case JournalOp::CreateListing: {
+        Listing listing;
+        listing.name = reader.str();
+        listing.quantity = reader.i32();
+        listing.price = reader.f64();
+        if (!reader.ok()) {
+            return false;
+        }
+        business.createListing(listing);
+        return true;
+    }
+    case JournalOp::UpdateListing: {
+        std::string name = reader.str();
+        int quantity = reader.i32();
+        double price = reader.f64();
+        if (!reader.ok()) {
+            return false;
+        }
+        business.updateListing(name, quantity, price);
+        return true;
+    }
+    case JournalOp::PlacePreorder: {
+        Preorder preorder;
+        preorder.itemName = reader.str();
+        preorder.quantity = reader.i32();
+        if (!reader.ok()) {
+            return false;
+        }
+        recipient.placePreorder(preorder);
+        return true;
+    }
+    case JournalOp::CancelPreorder: {
+        std::string itemName = reader.str();
+        if (!reader.ok()) {
+            return false;
+        }
+        recipient.cancelPreorder(itemName);
+        return true;
+    }
+    }
+    return false;
+}
+
+}  // namespace
+
+MarketStore::MarketStore(std::string directory, Options options)
+    : m_directory(std::move(directory)), m_options(options), m_lastSnapshot(std::chrono::steady_clock::now()) {}
+
+std::unique_ptr<MarketStore> MarketStore::open(const std::string& directory, BusinessInterface& business,
+                                               RecipientInterface& recipient, Options options) {
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        HUB_LOG_ERROR("Cannot create data directory {}: {}", directory, std::strerror(errno));
+        return nullptr;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<MarketStore> store(new MarketStore(directory, options));
+    store->m_snapshots = listSnapshots(directory);
+
+    uint64_t snapshotLsn = 0;
+    bool loaded = store->m_snapshots.empty();
+    for (auto it = store->m_snapshots.rbegin(); it != store->m_snapshots.rend() && !loaded; ++it) {
+        std::string path = directory + "/" + snapshotName(*it);
+        loaded = loadSnapshot(path, business, recipient, snapshotLsn);
+        if (!loaded) {
+            HUB_LOG_WARN("Snapshot {} is unreadable; trying an older one", path);
+        }
+    }
+    if (!loaded) {
+        HUB_LOG_ERROR("No readable snapshot in {}", directory);
+        return nullptr;
+    }
+
+    uint64_t replayed = 0;
+    store->m_wal = WriteAheadLog::open(
+        directory + "/wal", snapshotLsn,
+        [&](uint64_t lsn, const uint8_t* payload, size_t length) {
+            if (!applyRecord(payload, length, business, recipient)) {
+                HUB_LOG_WARN("Skipping malformed journal record at LSN {}", lsn);
+            }
+            ++replayed;
+        },
+        options.wal);
+    if (!store->m_wal) {
+        return nullptr;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    HUB_LOG_INFO("Recovered {} listings and {} preorders (snapshot LSN {}, {} log records) in {} ms",
+                 business.listingCount(), recipient.preorderCount(), snapshotLsn, replayed, elapsed.count());
+    storeMetrics().snapshotLsn.set(static_cast<int64_t>(snapshotLsn));
+    return store;
+}
+
+MarketStore::~MarketStore() {
+    stopCheckpointing();
+}
+
+uint64_t MarketStore::journal(const std::vector<uint8_t>& record) {
+    return m_wal->append(record.data(), record.size());
+}
+
+uint64_t MarketStore::logCreateListing(const Listing& listing) {
+    std::vector<uint8_t> record;
+    ByteWriter writer(record);
+    writer.u8(static_cast<uint8_t>(JournalOp::CreateListing));
+    writer.str(listing.name);
+    writer.i32(listing.quantity);
+    writer.f64(listing.price);
+    return journal(record);
+}
+
+uint64_t MarketStore::logUpdateListing(const std::string& name, int quantity, double price) {
+    std::vector<uint8_t> record;
+    ByteWriter writer(record);
+    writer.u8(static_cast<uint8_t>(JournalOp::UpdateListing));
+    writer.str(name);
+    writer.i32(quantity);
+    writer.f64(price);
+    return journal(record);
+}
+
+uint64_t MarketStore::logPlacePreorder(const Preorder& preorder) {
+    std::vector<uint8_t> record;
+    ByteWriter writer(record);
+    writer.u8(static_cast<uint8_t>(JournalOp::PlacePreorder));
+    writer.str(preorder.itemName);
+    writer.i32(preorder.quantity);
+    return journal(record);
+}
+
+uint64_t MarketStore::logCancelPreorder(const std::string& itemName) {
+    std::vector<uint8_t> record;
+    ByteWriter writer(record);
+    writer.u8(static_cast<uint8_t>(JournalOp::CancelPreorder));
+    writer.str(itemName);
+    return journal(record);
+}
+
+bool MarketStore::writeSnapshot(const Image& image) {
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    if (!m_snapshots.empty() && m_snapshots.back() >= image.lsn) {
+        m_lastSnapshot = std::chrono::steady_clock::now();
+        return true;
+    }
+    TraceSpan span("snapshot_write", storeMetrics().snapshotWrite);
+    std::string path = m_directory + "/" + snapshotName(image.lsn);
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        HUB_LOG_ERROR("Cannot create snapshot {}: {}", temporary, std::strerror(errno));
+        return false;
+    }
+
+    SnapshotHeader header{kSnapshotMagic, kSnapshotVersion, 0, image.lsn, image.listings.size(),
+                          image.preorders.size()};
+    std::vector<uint8_t> buffer(sizeof(header));
+    buffer.reserve(kWriteBufferBytes + 4096);
+    size_t headerBytes = sizeof(header);
+    uint32_t crc = 0;
+    bool ok = true;
+    auto drain = [&](bool force) {
+        if (ok && (force || buffer.size() >= kWriteBufferBytes)) {
+            crc = crc32(buffer.data() + headerBytes, buffer.size() - headerBytes, crc);
+            ok = writeAll(fd, buffer.data(), buffer.size());
+            buffer.clear();
+            headerBytes = 0;
+        }
+    };
+    ByteWriter writer(buffer);
+    image.listings.forEach([&](const Listing& listing) {
+        writer.str(listing.name);
+        writer.i32(listing.quantity);
+        writer.f64(listing.price);
+        drain(false);
+    });
+    image.preorders.forEach([&](const Preorder& preorder) {
+        writer.str(preorder.itemName);
+        writer.i32(preorder.quantity);
+        drain(false);
+    });
+    drain(true);
+    header.bodyCrc = crc;
+    ok = ok && ::pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+         ::fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        HUB_LOG_ERROR("Cannot write snapshot {}: {}", path, std::strerror(errno));
+        ::unlink(temporary.c_str());
+        return false;
+    }
+    syncDirectory(m_directory);
+
+    m_snapshots.push_back(image.lsn);
+    while (m_snapshots.size() > 2) {
+        ::unlink((m_directory + "/" + snapshotName(m_snapshots.front())).c_str());
+        m_snapshots.erase(m_snapshots.begin());
+    }
+    // Keep the log back to the older snapshot so it remains a usable fallback.
+    m_wal->discardThrough(m_snapshots.front());
+    m_lastSnapshot = std::chrono::steady_clock::now();
+
+    storeMetrics().snapshots.add();
+    storeMetrics().snapshotLsn.set(static_cast<int64_t>(image.lsn));
+    HUB_LOG_INFO("Wrote snapshot at LSN {} ({} listings, {} preorders)", image.lsn, image.listings.size(),
+                 image.preorders.size());
+    return true;
+}
+
+bool MarketStore::snapshotDue() const {
+    uint64_t logBytes = m_wal->bytesSinceRoll();
+    if (logBytes >= m_options.snapshotWalBytes) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return logBytes > 0 && std::chrono::steady_clock::now() - m_lastSnapshot >= m_options.snapshotInterval;
+}
+
+uint64_t MarketStore::snapshotLsn() const {
+    std::lock_guard<std::mutex> lock(m_snapshotMutex);
+    return m_snapshots.empty() ? 0 : m_snapshots.back();
+}
+
+void MarketStore::startCheckpointing(std::function<bool()> checkpoint) {
+    stopCheckpointing();
+    m_checkpointStopping = false;
+    m_checkpointThread = std::thread([this, checkpoint] {
+        std::unique_lock<std::mutex> lock(m_checkpointMutex);
+        while (!m_checkpointStopping) {
+            m_checkpointWake.wait_for(lock, std::chrono::seconds(1));
+            if (m_checkpointStopping || !snapshotDue()) {
+                continue;
+            }
+            lock.unlock();
+            checkpoint();
+            lock.lock();
+        }
+    });
+}
+
+void MarketStore::stopCheckpointing() {
+    {
+        std::lock_guard<std::mutex> lock(m_checkpointMutex);
+        m_checkpointStopping = true;
+    }
+    m_checkpointWake.notify_all();
+    if (m_checkpointThread.joinable()) {
+        m_checkpointThread.join();
+    }
+}
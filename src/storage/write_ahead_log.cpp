@@ -0,0 +1,373 @@
+#include "storage/write_ahead_log.h"
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kRecordHeaderBytes = 16;  // crc32, length, lsn
+constexpr char kSegmentPrefix[] = "wal-";
+
+constexpr std::array<uint32_t, 256> makeCrcTable() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t value = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+        }
+        table[i] = value;
+    }
+    return table;
+}
+
+constexpr std::array<uint32_t, 256> kCrcTable = makeCrcTable();
+
+struct WalMetrics {
+    LatencyHistogram& fsyncLatency = MetricsRegistry::instance().histogram("wal_fsync_ns");
+    Counter& records = MetricsRegistry::instance().counter("wal_records");
+    Counter& bytes = MetricsRegistry::instance().counter("wal_bytes");
+    Counter& groupCommits = MetricsRegistry::instance().counter("wal_group_commits");
+};
+
+WalMetrics& walMetrics() {
+    static WalMetrics metrics;
+    return metrics;
+}
+
+std::string segmentName(uint64_t firstLsn) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%s%016" PRIx64, kSegmentPrefix, firstLsn);
+    return name;
+}
+
+bool parseSegmentName(const char* name, uint64_t& firstLsn) {
+    size_t prefixLength = sizeof(kSegmentPrefix) - 1;
+    if (std::strncmp(name, kSegmentPrefix, prefixLength) != 0 || std::strlen(name) != prefixLength + 16) {
+        return false;
+    }
+    char* end = nullptr;
+    firstLsn = std::strtoull(name + prefixLength, &end, 16);
+    return end && *end == '\0';
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& contents) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    contents.resize(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (done < contents.size()) {
+        ssize_t n = ::read(fd, contents.data() + done, contents.size() - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    contents.resize(done);
+    return true;
+}
+
+bool writeAll(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = ::write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+}  // namespace
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = kCrcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+WriteAheadLog::WriteAheadLog(std::string directory, Options options)
+    : m_directory(std::move(directory)), m_options(options) {}
+
+std::unique_ptr<WriteAheadLog> WriteAheadLog::open(const std::string& directory, uint64_t afterLsn,
+                                                   const ReplayFn& replay, Options options) {
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        HUB_LOG_ERROR("Cannot create WAL directory {}: {}", directory, std::strerror(errno));
+        return nullptr;
+    }
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        HUB_LOG_ERROR("Cannot open WAL directory {}: {}", directory, std::strerror(errno));
+        return nullptr;
+    }
+    std::vector<uint64_t> segments;
+    while (dirent* entry = ::readdir(dir)) {
+        uint64_t firstLsn = 0;
+        if (parseSegmentName(entry->d_name, firstLsn)) {
+            segments.push_back(firstLsn);
+        }
+    }
+    ::closedir(dir);
+    std::sort(segments.begin(), segments.end());
+
+    std::unique_ptr<WriteAheadLog> log(new WriteAheadLog(directory, options));
+    uint64_t lastLsn = 0;
+    std::vector<uint8_t> contents;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        std::string path = directory + "/" + segmentName(segments[i]);
+        if (!readFile(path, contents)) {
+            HUB_LOG_ERROR("Cannot read WAL segment {}", path);
+            return nullptr;
+        }
+        size_t offset = 0;
+        bool torn = false;
+        while (offset < contents.size()) {
+            if (contents.size() - offset < kRecordHeaderBytes) {
+                torn = true;
+                break;
+            }
+            uint32_t crc;
+            uint32_t length;
+            uint64_t lsn;
+            std::memcpy(&crc, &contents[offset], 4);
+            std::memcpy(&length, &contents[offset + 4], 4);
+            std::memcpy(&lsn, &contents[offset + 8], 8);
+            if (contents.size() - offset - kRecordHeaderBytes < length || lsn <= lastLsn ||
+                crc32(&contents[offset + 4], kRecordHeaderBytes - 4 + length) != crc) {
+                torn = true;
+                break;
+            }
+            if (lsn > afterLsn) {
+                replay(lsn, &contents[offset + kRecordHeaderBytes], length);
+            }
+            lastLsn = lsn;
+            offset += kRecordHeaderBytes + length;
+        }
+        if (torn) {
+            // Everything from here on was never acknowledged as durable.
+            HUB_LOG_WARN("WAL segment {} torn at offset {}; truncating", path, offset);
+            if (::truncate(path.c_str(), static_cast<off_t>(offset)) != 0) {
+                HUB_LOG_ERROR("Cannot truncate {}: {}", path, std::strerror(errno));
+                return nullptr;
+            }
+            for (size_t later = i + 1; later < segments.size(); ++later) {
+                ::unlink((directory + "/" + segmentName(segments[later])).c_str());
+            }
+            segments.resize(i + 1);
+            break;
+        }
+    }
+
+    log->m_segments = segments;
+    log->m_lastLsn = std::max(lastLsn, afterLsn);
+    log->m_durableLsn = log->m_lastLsn;
+    if (!log->openSegment(log->m_lastLsn + 1)) {
+        return nullptr;
+    }
+    log->m_flusher = std::thread(&WriteAheadLog::flushLoop, log.get());
+    return log;
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_flushWanted.notify_one();
+    if (m_flusher.joinable()) {
+        m_flusher.join();
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+uint64_t WriteAheadLog::append(const uint8_t* payload, size_t length) {
+    uint32_t length32 = static_cast<uint32_t>(length);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_failed) {
+        return 0;
+    }
+    uint64_t lsn = ++m_lastLsn;
+    bool wasEmpty = m_pending.empty();
+    if (wasEmpty) {
+        m_pendingFirstLsn = lsn;
+    }
+    uint8_t header[kRecordHeaderBytes];
+    std::memcpy(header + 4, &length32, 4);
+    std::memcpy(header + 8, &lsn, 8);
+    uint32_t crc = crc32(payload, length, crc32(header + 4, kRecordHeaderBytes - 4));
+    std::memcpy(header, &crc, 4);
+    m_pending.insert(m_pending.end(), header, header + kRecordHeaderBytes);
+    m_pending.insert(m_pending.end(), payload, payload + length);
+    m_bytesSinceRoll += kRecordHeaderBytes + length;
+    if (wasEmpty) {
+        m_flushWanted.notify_one();
+    }
+    return lsn;
+}
+
+bool WriteAheadLog::waitDurable(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_durable.wait(lock, [&] { return m_durableLsn >= lsn || m_failed; });
+    return m_durableLsn >= lsn;
+}
+
+bool WriteAheadLog::failed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_failed;
+}
+
+uint64_t WriteAheadLog::lastLsn() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastLsn;
+}
+
+uint64_t WriteAheadLog::durableLsn() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_durableLsn;
+}
+
+uint64_t WriteAheadLog::bytesSinceRoll() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytesSinceRoll;
+}
+
+void WriteAheadLog::rollSegment() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rollRequested = true;
+    m_bytesSinceRoll = 0;
+}
+
+void WriteAheadLog::discardThrough(uint64_t lsn) {
+    std::vector<uint64_t> doomed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t keepFrom = 0;
+        // The last segment is still being written and is never dropped.
+        while (keepFrom + 1 < m_segments.size() && m_segments[keepFrom + 1] - 1 <= lsn) {
+            ++keepFrom;
+        }
+        doomed.assign(m_segments.begin(), m_segments.begin() + static_cast<long>(keepFrom));
+        m_segments.erase(m_segments.begin(), m_segments.begin() + static_cast<long>(keepFrom));
+    }
+    for (uint64_t firstLsn : doomed) {
+        ::unlink((m_directory + "/" + segmentName(firstLsn)).c_str());
+    }
+}
+
+bool WriteAheadLog::openSegment(uint64_t firstLsn) {
+    std::string path = m_directory + "/" + segmentName(firstLsn);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        HUB_LOG_ERROR("Cannot open WAL segment {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    struct stat info {};
+    ::fstat(fd, &info);
+    syncDirectory(m_directory);
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+    m_fd = fd;
+    m_segmentSize = static_cast<size_t>(info.st_size);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_segments.empty() || m_segments.back() < firstLsn) {
+        m_segments.push_back(firstLsn);
+    }
+    return true;
+}
+
+void WriteAheadLog::flushLoop() {
+    WalMetrics& metrics = walMetrics();
+    std::vector<uint8_t> batch;
+    for (;;) {
+        uint64_t firstLsn;
+        uint64_t lastLsn;
+        bool roll;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_flushWanted.wait(lock, [this] { return !m_pending.empty() || m_stopping; });
+            if (m_pending.empty()) {
+                return;
+            }
+            batch.swap(m_pending);
+            firstLsn = m_pendingFirstLsn;
+            lastLsn = m_lastLsn;
+            roll = m_rollRequested;
+            m_rollRequested = false;
+        }
+
+        bool ok = true;
+        if ((roll || m_segmentSize >= m_options.segmentBytes) && m_segmentSize > 0) {
+            ok = openSegment(firstLsn);
+        }
+        auto start = std::chrono::steady_clock::now();
+        ok = ok && writeAll(m_fd, batch.data(), batch.size()) && ::fdatasync(m_fd) == 0;
+        metrics.fsyncLatency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        if (ok) {
+            m_segmentSize += batch.size();
+            metrics.records.add(lastLsn - firstLsn + 1);
+            metrics.bytes.add(batch.size());
+            metrics.groupCommits.add();
+        } else {
+            HUB_LOG_ERROR("WAL write failed at LSN {}: {}", firstLsn, std::strerror(errno));
+            // Records of a failed batch may have reached the file; cut them
+            // off so a restart never replays writes that were reported lost.
+            if (::ftruncate(m_fd, static_cast<off_t>(m_segmentSize)) != 0) {
+                HUB_LOG_ERROR("Cannot truncate WAL after failed write: {}", std::strerror(errno));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (ok) {
+                m_durableLsn = lastLsn;
+            } else {
+                m_failed = true;
+                m_pending.clear();
+            }
+        }
+        m_durable.notify_all();
+        if (!ok) {
+            return;
+        }
+        batch.clear();
+    }
+}
@@ -0,0 +1,177 @@
+#include "ultrasonic/acoustic_channel.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+// Kaiser-windowed sinc, tabulated at kPhases fractional offsets. Flat to
+// within 0.05 dB up to 0.45 fs, which covers every carrier the modem uses;
+// cubic interpolation would already cost over a decibel at 15 kHz.
+constexpr int kTaps = 64;
+constexpr int kPhases = 512;
+
+double besselI0(double x) {
+    double sum = 1, term = 1;
+    for (int k = 1; k < 30; ++k) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+const std::vector<float>& sincTable() {
+    static const std::vector<float> table = [] {
+        constexpr double kBeta = 8.0;
+        std::vector<float> taps(size_t(kPhases + 1) * kTaps);
+        for (int phase = 0; phase <= kPhases; ++phase) {
+            double fraction = static_cast<double>(phase) / kPhases;
+            for (int tap = 0; tap < kTaps; ++tap) {
+                double x = tap - (kTaps / 2 - 1) - fraction;
+                double sinc = x == 0 ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+                double ratio = x / (kTaps / 2);
+                double window = std::abs(ratio) < 1 ? besselI0(kBeta * std::sqrt(1 - ratio * ratio)) / besselI0(kBeta) : 0;
+                taps[size_t(phase) * kTaps + tap] = static_cast<float>(sinc * window);
+            }
+        }
+        return taps;
+    }();
+    return table;
+}
+
+float interpolate(const std::vector<float>& x, double position) {
+    long index = static_cast<long>(std::floor(position));
+    int phase = static_cast<int>(std::lround((position - static_cast<double>(index)) * kPhases));
+    const float* taps = sincTable().data() + size_t(phase) * kTaps;
+    long first = index - (kTaps / 2 - 1);
+    if (first >= 0 && first + kTaps <= static_cast<long>(x.size())) {
+        // Independent lanes so the compiler can vectorize the dot product.
+        const float* window = x.data() + first;
+        float sums[8] = {};
+        for (int tap = 0; tap < kTaps; tap += 8) {
+            for (int lane = 0; lane < 8; ++lane) {
+                sums[lane] += taps[tap + lane] * window[tap + lane];
+            }
+        }
+        return ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+    }
+    float sum = 0;
+    for (int tap = 0; tap < kTaps; ++tap) {
+        long i = first + tap;
+        if (i >= 0 && i < static_cast<long>(x.size())) {
+            sum += taps[tap] * x[i];
+        }
+    }
+    return sum;
+}
+
+// Marsaglia's polar method on both halves of one 64-bit draw, two samples
+// per accepted pair and no trig. std::normal_distribution took most of a
+// noisy trial; 32-bit uniforms still reach past 6 sigma.
+void addNoise(std::vector<float>& x, double sigma, std::mt19937_64& random) {
+    constexpr double kScale = 1.0 / 2147483648.0;
+    for (size_t i = 0; i < x.size();) {
+        uint64_t bits = random();
+        double u = (static_cast<double>(bits >> 32) - 2147483647.5) * kScale;
+        double v = (static_cast<double>(bits & 0xffffffffu) - 2147483647.5) * kScale;
+        double s = u * u + v * v;
+        if (s >= 1.0) {
+            continue;
+        }
+        double factor = sigma * std::sqrt(-2.0 * std::log(s) / s);
+        x[i++] += static_cast<float>(u * factor);
+        if (i < x.size()) {
+            x[i++] += static_cast<float>(v * factor);
+        }
+    }
+}
+
+}  // namespace
+
+AcousticChannel::AcousticChannel(Config config, uint64_t seed) : m_config(std::move(config)), m_random(seed) {
+    if (m_config.sampleRate <= 0) {
+        throw std::runtime_error("Channel needs a positive sample rate.");
+    }
+    // A NaN or inf here would turn into UB in lround, a huge buffer or a
+    // signal of NaNs. An infinite SNR is the one exception: it means no noise.
+    if (!std::isfinite(m_config.attenuationDb) || !std::isfinite(m_config.velocityMps) ||
+        !std::isfinite(m_config.clockDriftPpm) || std::isnan(m_config.snrDb) || m_config.snrDb == -INFINITY) {
+        throw std::runtime_error("Channel settings must be finite.");
+    }
+    if (m_config.velocityMps <= -kSpeedOfSound) {
+        throw std::runtime_error("Receiver can't outrun the sound it records.");
+    }
+    if (m_config.clockDriftPpm <= -1e6) {
+        throw std::runtime_error("Clock drift must leave the receiver clock running.");
+    }
+    for (const Echo& echo : m_config.echoes) {
+        if (!std::isfinite(echo.delaySeconds) || !std::isfinite(echo.gain)) {
+            throw std::runtime_error("Echo settings must be finite.");
+        }
+        if (echo.delaySeconds < 0) {
+            throw std::runtime_error("Echo delays must not be negative.");
+        }
+    }
+    for (const Transmitter& transmitter : m_config.transmitters) {
+        if (!std::isfinite(transmitter.gainDb)) {
+            throw std::runtime_error("Transmitter gains must be finite.");
+        }
+    }
+}
+
+double AcousticChannel::timeScale() const {
+    return (1.0 + m_config.clockDriftPpm * 1e-6) * kSpeedOfSound / (kSpeedOfSound + m_config.velocityMps);
+}
+
+std::vector<int16_t> AcousticChannel::transmit(const std::vector<int16_t>& pcm) {
+    double gain = std::pow(10.0, -m_config.attenuationDb / 20.0);
+    double power = 0;
+    for (int16_t sample : pcm) {
+        power += (gain * sample) * (gain * sample);
+    }
+    power /= std::max<size_t>(pcm.size(), 1);
+
+    size_t longestEcho = 0;
+    for (const Echo& echo : m_config.echoes) {
+        longestEcho = std::max(longestEcho, static_cast<size_t>(std::lround(echo.delaySeconds * m_config.sampleRate)));
+    }
+    // Single precision keeps well over 16 bits and halves the resampler's memory traffic.
+    std::vector<float> air(pcm.size() + longestEcho, 0.0f);
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        air[i] = static_cast<float>(gain * pcm[i]);
+    }
+    for (const Echo& echo : m_config.echoes) {
+        size_t delay = static_cast<size_t>(std::lround(echo.delaySeconds * m_config.sampleRate));
+        for (size_t i = 0; i < pcm.size(); ++i) {
+            air[i + delay] += static_cast<float>(echo.gain * gain * pcm[i]);
+        }
+    }
+
+    double scale = timeScale();
+    std::vector<float> received;
+    if (scale == 1.0) {
+        received = std::move(air);
+    } else {
+        received.resize(static_cast<size_t>(std::floor(static_cast<double>(air.size()) * scale)));
+        for (size_t n = 0; n < received.size(); ++n) {
+            received[n] = interpolate(air, static_cast<double>(n) / scale);
+        }
+    }
+
+    for (const Transmitter& transmitter : m_config.transmitters) {
+        double level = std::pow(10.0, transmitter.gainDb / 20.0);
+        for (size_t i = 0; i < transmitter.pcm.size() && transmitter.offset + i < received.size(); ++i) {
+            received[transmitter.offset + i] += static_cast<float>(level * transmitter.pcm[i]);
+        }
+    }
+
+    if (std::isfinite(m_config.snrDb)) {
+        addNoise(received, std::sqrt(power / std::pow(10.0, m_config.snrDb / 10.0)), m_random);
+    }
+
+    std::vector<int16_t> out(received.size());
+    for (size_t i = 0; i < received.size(); ++i) {
+        out[i] = static_cast<int16_t>(std::lround(std::clamp(received[i], -32768.0f, 32767.0f)));
+    }
+    return out;
+}
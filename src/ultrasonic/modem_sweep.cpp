@@ -0,0 +1,134 @@
+#include "ultrasonic/modem_sweep.h"
+#include "ultrasonic/ultrasonic_modem.h"
+#include "ultrasonic/waveform_synthesizer.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+ModemSweep::ModemSweep(Config config) : m_config(std::move(config)) {
+    if (m_config.payloadBytes == 0 || m_config.trialsPerPoint == 0) {
+        throw std::runtime_error("Sweep needs a payload and at least one trial per point.");
+    }
+}
+
+std::vector<ModemSweep::Result> ModemSweep::run(const std::vector<Point>& points) const {
+    const Modem& settings = m_config.modem;
+    // Bad channel settings throw here, on the caller's thread, rather than
+    // from a worker where they would terminate the process.
+    for (const Point& point : points) {
+        AcousticChannel::Config channelConfig = point.channel;
+        channelConfig.sampleRate = settings.sampleRate;
+        AcousticChannel check(std::move(channelConfig));
+    }
+    unsigned threads = m_config.threads ? m_config.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t jobs = points.size() * m_config.trialsPerPoint;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(jobs, 1)));
+
+    std::atomic<size_t> nextJob{0};
+    std::mutex failureMutex;
+    std::exception_ptr failure;
+    std::vector<std::vector<Result>> partials(threads, std::vector<Result>(points.size()));
+    auto trials = [&](std::vector<Result>& results) {
+        // Synthesizers aren't thread-safe and modems are cheap: one of each per worker.
+        WaveformSynthesizer synthesizer(settings.sampleRate, settings.f0, settings.df, settings.samplesPerFrame);
+        UltrasonicModem modem(settings.sampleRate, settings.f0, settings.df, settings.samplesPerFrame);
+        std::vector<uint8_t> payload(m_config.payloadBytes);
+        std::vector<int16_t> pcm;
+        std::vector<bool> bits;
+
+        for (size_t job = nextJob++; job < jobs; job = nextJob++) {
+            size_t point = job / m_config.trialsPerPoint;
+            size_t trial = job % m_config.trialsPerPoint;
+            std::seed_seq seeds{static_cast<uint32_t>(m_config.seed), static_cast<uint32_t>(m_config.seed >> 32),
+                                static_cast<uint32_t>(point), static_cast<uint32_t>(trial)};
+            std::mt19937_64 random(seeds);
+            for (auto& byte : payload) {
+                byte = static_cast<uint8_t>(random());
+            }
+
+            pcm.clear();
+            synthesizer.synthesize(payload.data(), payload.size(), pcm);
+            double airtime = static_cast<double>(pcm.size()) / settings.sampleRate;
+            // The receiver keeps recording for a frame past the transmission,
+            // so a channel that compresses time doesn't clip the last bit.
+            pcm.resize(pcm.size() + settings.samplesPerFrame, 0);
+            AcousticChannel::Config channelConfig = points[point].channel;
+            channelConfig.sampleRate = settings.sampleRate;
+            AcousticChannel channel(std::move(channelConfig), random());
+            std::vector<int16_t> recorded = channel.transmit(pcm);
+
+            bits.clear();
+            modem.decodeBits(recorded.data(), recorded.size(), bits);
+            uint64_t errors = 0;
+            for (size_t i = 0; i < payload.size() * 8; ++i) {
+                bool sent = (payload[i / 8] >> (i % 8)) & 1;
+                // Bits lost off the end of the recording count as errors.
+                errors += i >= bits.size() || bits[i] != sent ? 1 : 0;
+            }
+
+            Result& result = results[point];
+            ++result.trials;
+            result.bits += payload.size() * 8;
+            result.bitErrors += errors;
+            result.payloadsIntact += errors == 0 ? 1 : 0;
+            result.airtimeSeconds += airtime;
+        }
+    };
+    // Anything else a worker throws is handed back to the caller after the
+    // join; the remaining jobs are abandoned.
+    auto worker = [&](std::vector<Result>& results) {
+        try {
+            trials(results);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+            nextJob = jobs;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker, std::ref(partials[i]));
+    }
+    worker(partials[0]);
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    std::vector<Result> results(points.size());
+    for (size_t point = 0; point < points.size(); ++point) {
+        results[point].label = points[point].label;
+        for (const auto& partial : partials) {
+            results[point].trials += partial[point].trials;
+            results[point].bits += partial[point].bits;
+            results[point].bitErrors += partial[point].bitErrors;
+            results[point].payloadsIntact += partial[point].payloadsIntact;
+            results[point].airtimeSeconds += partial[point].airtimeSeconds;
+        }
+    }
+    return results;
+}
+
+void ModemSweep::report(std::ostream& out, const std::vector<Result>& results) const {
+    out << std::left << std::setw(24) << "point" << std::right << std::setw(12) << "ber" << std::setw(10) << "intact"
+        << std::setw(14) << "goodput_bps" << '\n';
+    for (const Result& result : results) {
+        out << std::left << std::setw(24) << result.label << std::right << std::setw(12) << std::setprecision(4)
+            << result.bitErrorRate() << std::setw(10) << std::setprecision(3)
+            << static_cast<double>(result.payloadsIntact) / std::max<uint64_t>(result.trials, 1) << std::setw(14)
+            << std::setprecision(4) << result.goodputBps(m_config.payloadBytes) << '\n';
+    }
+    out.flush();
+}
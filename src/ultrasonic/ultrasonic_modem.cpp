@@ -0,0 +1,120 @@
+#include "ultrasonic/ultrasonic_modem.h"
+#include "ultrasonic/modem_profile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+template <typename Profile>
+bool matches(int sampleRate, double f0, double df, int samplesPerFrame) {
+    return sampleRate == Profile::kSampleRate && f0 == Profile::kSpaceHz && f0 + df == Profile::kMarkHz &&
+           samplesPerFrame == Profile::kSamplesPerFrame;
+}
+
+template <typename Profile>
+void decodeSpecialized(const UltrasonicModem&, const int16_t* pcm, size_t count, std::vector<bool>& bits) {
+    FskModem<Profile>::decodeBits(pcm, count, bits);
+}
+
+std::vector<int16_t> toneTable(int sampleRate, double hz, int samples) {
+    std::vector<int16_t> tone(samples);
+    for (int i = 0; i < samples; ++i) {
+        tone[i] = modem_detail::toSample(std::sin(2.0 * modem_detail::kPi * hz * i / sampleRate));
+    }
+    return tone;
+}
+
+}  // namespace
+
+UltrasonicModem::UltrasonicModem(int sampleRate, double f0, double df, int samplesPerFrame)
+    : m_samplesPerFrame(samplesPerFrame) {
+    if (sampleRate <= 0 || samplesPerFrame <= 0) {
+        throw std::runtime_error("Modem needs a positive sample rate and frame length.");
+    }
+    if (f0 <= 0 || df == 0 || 2 * std::max(f0, f0 + df) >= sampleRate) {
+        throw std::runtime_error("Modem carriers must be distinct and below Nyquist.");
+    }
+
+    if (matches<Profile48k15k1k>(sampleRate, f0, df, samplesPerFrame)) {
+        m_decode = &decodeSpecialized<Profile48k15k1k>;
+        m_spaceTone.assign(Profile48k15k1k::kSpaceTone.begin(), Profile48k15k1k::kSpaceTone.end());
+        m_markTone.assign(Profile48k15k1k::kMarkTone.begin(), Profile48k15k1k::kMarkTone.end());
+        m_specialized = true;
+    } else if (matches<Profile48k15k5k>(sampleRate, f0, df, samplesPerFrame)) {
+        m_decode = &decodeSpecialized<Profile48k15k5k>;
+        m_spaceTone.assign(Profile48k15k5k::kSpaceTone.begin(), Profile48k15k5k::kSpaceTone.end());
+        m_markTone.assign(Profile48k15k5k::kMarkTone.begin(), Profile48k15k5k::kMarkTone.end());
+        m_specialized = true;
+    } else {
+        m_spaceTone = toneTable(sampleRate, f0, samplesPerFrame);
+        m_markTone = toneTable(sampleRate, f0 + df, samplesPerFrame);
+        m_spaceCoeff = 2.0 * std::cos(2.0 * modem_detail::kPi * f0 / sampleRate);
+        m_markCoeff = 2.0 * std::cos(2.0 * modem_detail::kPi * (f0 + df) / sampleRate);
+    }
+}
+
+void UltrasonicModem::encode(const uint8_t* data, size_t length, std::vector<int16_t>& pcm) const {
+    size_t frame = static_cast<size_t>(m_samplesPerFrame);
+    size_t offset = pcm.size();
+    pcm.resize(offset + length * 8 * frame);
+    int16_t* out = pcm.data() + offset;
+    for (size_t i = 0; i < length; ++i) {
+        for (int bit = 0; bit < 8; ++bit) {
+            const auto& tone = (data[i] >> bit) & 1 ? m_markTone : m_spaceTone;
+            std::memcpy(out, tone.data(), frame * sizeof(int16_t));
+            out += frame;
+        }
+    }
+}
+
+std::vector<int16_t> UltrasonicModem::encode(const std::string& data) const {
+    std::vector<int16_t> pcm;
+    encode(reinterpret_cast<const uint8_t*>(data.data()), data.size(), pcm);
+    return pcm;
+}
+
+void UltrasonicModem::decodeBits(const int16_t* pcm, size_t count, std::vector<bool>& bits) const {
+    m_decode(*this, pcm, count, bits);
+}
+
+std::vector<bool> UltrasonicModem::decodeBits(const std::vector<int16_t>& pcm) const {
+    std::vector<bool> bits;
+    bits.reserve(pcm.size() / m_samplesPerFrame);
+    decodeBits(pcm.data(), pcm.size(), bits);
+    return bits;
+}
+
+std::string UltrasonicModem::decode(const std::vector<int16_t>& pcm) const {
+    std::vector<bool> bits = decodeBits(pcm);
+    std::string bytes(bits.size() / 8, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        uint8_t byte = 0;
+        for (int bit = 0; bit < 8; ++bit) {
+            byte |= static_cast<uint8_t>(bits[i * 8 + bit]) << bit;
+        }
+        bytes[i] = static_cast<char>(byte);
+    }
+    return bytes;
+}
+
+void UltrasonicModem::decodeGeneric(const UltrasonicModem& modem, const int16_t* pcm, size_t count,
+                                    std::vector<bool>& bits) {
+    size_t frame = static_cast<size_t>(modem.m_samplesPerFrame);
+    for (size_t offset = 0; offset + frame <= count; offset += frame) {
+        double space1 = 0, space2 = 0, mark1 = 0, mark2 = 0;
+        for (size_t i = 0; i < frame; ++i) {
+            double x = pcm[offset + i];
+            double space0 = x + modem.m_spaceCoeff * space1 - space2;
+            double mark0 = x + modem.m_markCoeff * mark1 - mark2;
+            space2 = space1;
+            space1 = space0;
+            mark2 = mark1;
+            mark1 = mark0;
+        }
+        double space = space1 * space1 + space2 * space2 - modem.m_spaceCoeff * space1 * space2;
+        double mark = mark1 * mark1 + mark2 * mark2 - modem.m_markCoeff * mark1 * mark2;
+        bits.push_back(mark > space);
+    }
+}
@@ -0,0 +1,160 @@
+#include "ultrasonic/waveform_synthesizer.h"
+#include "metrics/metrics.h"
+#include "ultrasonic/modem_profile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+struct SynthesizerMetrics {
+    Counter& cacheHits = MetricsRegistry::instance().counter("ultrasonic_pcm_cache_hits");
+    Counter& cacheMisses = MetricsRegistry::instance().counter("ultrasonic_pcm_cache_misses");
+};
+
+SynthesizerMetrics& synthesizerMetrics() {
+    static SynthesizerMetrics metrics;
+    return metrics;
+}
+
+uint32_t phaseStep(double hz, int sampleRate) {
+    return static_cast<uint32_t>(std::llround(hz / sampleRate * 4294967296.0));
+}
+
+}  // namespace
+
+WaveformSynthesizer::WaveformSynthesizer(int sampleRate, double f0, double df, int samplesPerFrame, Config config)
+    : m_samplesPerFrame(samplesPerFrame), m_config(config), m_sine(size_t(1) << kTableBits) {
+    if (sampleRate <= 0 || samplesPerFrame <= 0) {
+        throw std::runtime_error("Synthesizer needs a positive sample rate and frame length.");
+    }
+    if (f0 <= 0 || df == 0 || 2 * std::max(f0, f0 + df) >= sampleRate) {
+        throw std::runtime_error("Synthesizer carriers must be distinct and below Nyquist.");
+    }
+    m_spaceStep = phaseStep(f0, sampleRate);
+    m_markStep = phaseStep(f0 + df, sampleRate);
+    for (size_t i = 0; i < m_sine.size(); ++i) {
+        m_sine[i] = modem_detail::toSample(std::sin(2.0 * modem_detail::kPi * i / m_sine.size()));
+    }
+
+    if (std::floor(f0) == f0 && std::floor(df) == df) {
+        // Whole-hertz carriers: count phase exactly in 1/sampleRate cycles so
+        // a frame of whole cycles lands back on zero.
+        m_phaseModulus = static_cast<uint64_t>(sampleRate);
+        m_spaceAdvance = static_cast<uint64_t>(f0) * samplesPerFrame % m_phaseModulus;
+        m_markAdvance = static_cast<uint64_t>(f0 + df) * samplesPerFrame % m_phaseModulus;
+    } else {
+        m_phaseModulus = uint64_t(1) << 32;
+        m_spaceAdvance = uint64_t(m_spaceStep) * samplesPerFrame % m_phaseModulus;
+        m_markAdvance = uint64_t(m_markStep) * samplesPerFrame % m_phaseModulus;
+    }
+}
+
+uint32_t WaveformSynthesizer::accumulatorPhase(uint64_t phase) const {
+    return static_cast<uint32_t>((phase << 32) / m_phaseModulus);
+}
+
+void WaveformSynthesizer::runOscillator(bool bit, uint32_t phase, int16_t* out) const {
+    uint32_t step = bit ? m_markStep : m_spaceStep;
+    constexpr uint32_t kShift = 32 - kTableBits;
+    constexpr uint32_t kRound = uint32_t(1) << (kShift - 1);
+    for (int i = 0; i < m_samplesPerFrame; ++i) {
+        out[i] = m_sine[static_cast<uint32_t>(phase + kRound) >> kShift];
+        phase += step;
+    }
+}
+
+const int16_t* WaveformSynthesizer::symbolTable(bool bit, uint64_t phase) {
+    uint64_t key = (phase << 1) | (bit ? 1 : 0);
+    auto it = m_symbols.find(key);
+    if (it != m_symbols.end()) {
+        return it->second.data();
+    }
+    if (m_symbols.size() >= m_config.maxSymbolTables) {
+        return nullptr;
+    }
+    std::vector<int16_t> table(m_samplesPerFrame);
+    runOscillator(bit, accumulatorPhase(phase), table.data());
+    m_stats.symbolTables = m_symbols.size() + 1;
+    return m_symbols.emplace(key, std::move(table)).first->second.data();
+}
+
+void WaveformSynthesizer::synthesize(const uint8_t* data, size_t length, std::vector<int16_t>& pcm) {
+    size_t frame = static_cast<size_t>(m_samplesPerFrame);
+    size_t offset = pcm.size();
+    pcm.resize(offset + length * 8 * frame);
+    int16_t* out = pcm.data() + offset;
+
+    if (!m_config.continuousPhase || (m_spaceAdvance == 0 && m_markAdvance == 0)) {
+        // Every symbol starts at phase zero: two tables cover the message.
+        const int16_t* tables[2] = {symbolTable(false, 0), symbolTable(true, 0)};
+        if (tables[0] && tables[1]) {
+            for (size_t i = 0; i < length; ++i) {
+                for (int bit = 0; bit < 8; ++bit) {
+                    std::memcpy(out, tables[(data[i] >> bit) & 1], frame * sizeof(int16_t));
+                    out += frame;
+                }
+            }
+            return;
+        }
+    }
+
+    uint64_t phase = 0;
+    for (size_t i = 0; i < length; ++i) {
+        for (int bit = 0; bit < 8; ++bit) {
+            bool one = (data[i] >> bit) & 1;
+            if (const int16_t* table = symbolTable(one, phase)) {
+                std::memcpy(out, table, frame * sizeof(int16_t));
+            } else {
+                runOscillator(one, accumulatorPhase(phase), out);
+            }
+            if (m_config.continuousPhase) {
+                phase = (phase + (one ? m_markAdvance : m_spaceAdvance)) % m_phaseModulus;
+            }
+            out += frame;
+        }
+    }
+}
+
+std::vector<int16_t> WaveformSynthesizer::synthesize(const std::string& data) {
+    std::vector<int16_t> pcm;
+    synthesize(reinterpret_cast<const uint8_t*>(data.data()), data.size(), pcm);
+    return pcm;
+}
+
+WaveformSynthesizer::Pcm WaveformSynthesizer::cached(const std::string& payload) {
+    auto it = m_cache.find(payload);
+    if (it != m_cache.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        ++m_stats.cacheHits;
+        synthesizerMetrics().cacheHits.add();
+        return it->second->second;
+    }
+    ++m_stats.cacheMisses;
+    synthesizerMetrics().cacheMisses.add();
+
+    auto pcm = std::make_shared<std::vector<int16_t>>();
+    synthesize(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), *pcm);
+    size_t bytes = pcm->size() * sizeof(int16_t);
+    if (bytes > m_config.cacheBytes) {
+        return pcm;
+    }
+    while (m_stats.cachedBytes + bytes > m_config.cacheBytes) {
+        auto& oldest = m_lru.back();
+        m_stats.cachedBytes -= oldest.second->size() * sizeof(int16_t);
+        m_cache.erase(oldest.first);
+        m_lru.pop_back();
+        ++m_stats.cacheEvictions;
+    }
+    m_lru.emplace_front(payload, pcm);
+    m_cache.emplace(payload, m_lru.begin());
+    m_stats.cachedBytes += bytes;
+    return pcm;
+}
+
+void WaveformSynthesizer::clearCache() {
+    m_cache.clear();
+    m_lru.clear();
+    m_stats.cachedBytes = 0;
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "ultrasonic/acoustic_channel.h"
+#include "ultrasonic/modem_sweep.h"
+#include "ultrasonic/waveform_synthesizer.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<int16_t> tone(double hz, size_t samples, double amplitude = 16000.0) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        pcm[i] = static_cast<int16_t>(amplitude * std::sin(2 * M_PI * hz * i / 48000));
+    }
+    return pcm;
+}
+
+double rms(const std::vector<int16_t>& pcm) {
+    double sum = 0;
+    for (int16_t sample : pcm) {
+        sum += static_cast<double>(sample) * sample;
+    }
+    return std::sqrt(sum / pcm.size());
+}
+
+// Frequency of the strongest bin near `expected`, by brute-force DFT.
+double peakFrequency(const std::vector<int16_t>& pcm, double expected) {
+    double best = 0;
+    double bestHz = 0;
+    for (double hz = expected - 200; hz <= expected + 200; hz += 1) {
+        double re = 0, im = 0;
+        for (size_t i = 0; i < pcm.size(); ++i) {
+            re += pcm[i] * std::cos(2 * M_PI * hz * i / 48000);
+            im += pcm[i] * std::sin(2 * M_PI * hz * i / 48000);
+        }
+        if (re * re + im * im > best) {
+            best = re * re + im * im;
+            bestHz = hz;
+        }
+    }
+    return bestHz;
+}
+
+}  // namespace
+
+TEST(AcousticChannelTest, CleanChannelIsTransparent) {
+    std::vector<int16_t> pcm = tone(15000, 4800);
+    EXPECT_EQ(pcm, AcousticChannel(AcousticChannel::Config()).transmit(pcm));
+}
+
+TEST(AcousticChannelTest, AttenuatesAndAddsEchoes) {
+    AcousticChannel::Config config;
+    config.attenuationDb = 20;
+    config.echoes = {{0.001, 0.5}};
+    std::vector<int16_t> impulse(100, 0);
+    impulse[0] = 30000;
+
+    std::vector<int16_t> out = AcousticChannel(config).transmit(impulse);
+    ASSERT_EQ(100u + 48, out.size());
+    EXPECT_EQ(3000, out[0]);
+    EXPECT_EQ(1500, out[48]);
+    EXPECT_EQ(0, out[47]);
+}
+
+TEST(AcousticChannelTest, DopplerAndDriftRescaleTime) {
+    AcousticChannel::Config config;
+    config.velocityMps = 3.43;  // 1% closing speed
+    AcousticChannel channel(config);
+    std::vector<int16_t> pcm = tone(15000, 9600);
+    std::vector<int16_t> out = channel.transmit(pcm);
+
+    EXPECT_NEAR(9600 / 1.01, out.size(), 1);
+    EXPECT_NEAR(15150, peakFrequency(out, 15150), 10);
+    EXPECT_NEAR(rms(pcm), rms(out), rms(pcm) * 0.005);  // resampling keeps the band flat
+
+    config.velocityMps = 0;
+    config.clockDriftPpm = 1000;
+    EXPECT_NEAR(9600 * 1.001, AcousticChannel(config).transmit(pcm).size(), 1);
+}
+
+TEST(AcousticChannelTest, NoiseMatchesRequestedSnr) {
+    AcousticChannel::Config config;
+    config.attenuationDb = 6;
+    config.snrDb = 10;
+    std::vector<int16_t> pcm = tone(15000, 48000, 8000);
+    std::vector<int16_t> out = AcousticChannel(config, 42).transmit(pcm);
+
+    double signal = rms(pcm) * std::pow(10.0, -6.0 / 20);
+    std::vector<int16_t> noise(out.size());
+    for (size_t i = 0; i < out.size(); ++i) {
+        noise[i] = static_cast<int16_t>(out[i] - std::lround(pcm[i] * std::pow(10.0, -6.0 / 20)));
+    }
+    EXPECT_NEAR(10.0, 20 * std::log10(signal / rms(noise)), 0.2);
+}
+
+TEST(AcousticChannelTest, RejectsNonFiniteSettings) {
+    using Config = AcousticChannel::Config;
+    const double bad[] = {NAN, INFINITY, -INFINITY};
+    for (double value : bad) {
+        std::vector<void (*)(Config&, double)> setters = {
+            [](Config& c, double v) { c.attenuationDb = v; },
+            [](Config& c, double v) { c.velocityMps = v; },
+            [](Config& c, double v) { c.clockDriftPpm = v; },
+            [](Config& c, double v) { c.echoes = {{v, 0.5}}; },
+            [](Config& c, double v) { c.echoes = {{0.001, v}}; },
+            [](Config& c, double v) { c.transmitters = {{{}, v, 0}}; },
+        };
+        for (size_t i = 0; i < setters.size(); ++i) {
+            Config config;
+            setters[i](config, value);
+            EXPECT_THROW(AcousticChannel{config}, std::runtime_error) << "field " << i << " = " << value;
+        }
+    }
+    Config config;
+    config.snrDb = NAN;
+    EXPECT_THROW(AcousticChannel{config}, std::runtime_error);
+    config.snrDb = -INFINITY;
+    EXPECT_THROW(AcousticChannel{config}, std::runtime_error);
+    config.snrDb = INFINITY;  // no noise
+    EXPECT_NO_THROW(AcousticChannel{config});
+    config.clockDriftPpm = -1e6;
+    EXPECT_THROW(AcousticChannel{config}, std::runtime_error);
+}
+
+TEST(ModemSweepTest, ResultsDoNotDependOnThreadCount) {
+    ModemSweep::Config config;
+    config.trialsPerPoint = 40;
+    std::vector<ModemSweep::Point> points(2);
+    points[0].label = "snr -12 dB";
+    points[0].channel.snrDb = -12;
+    points[1].label = "snr -16 dB";
+    points[1].channel.snrDb = -16;
+
+    config.threads = 1;
+    auto serial = ModemSweep(config).run(points);
+    config.threads = 4;
+    auto parallel = ModemSweep(config).run(points);
+    for (size_t i = 0; i < points.size(); ++i) {
+        EXPECT_EQ(serial[i].trials, parallel[i].trials);
+        EXPECT_EQ(serial[i].bitErrors, parallel[i].bitErrors);
+        EXPECT_EQ(serial[i].payloadsIntact, parallel[i].payloadsIntact);
+    }
+    EXPECT_GT(serial[1].bitErrors, serial[0].bitErrors);
+}
+
+TEST(ModemSweepTest, BerAndGoodputCurves) {
+    ModemSweep::Config config;
+    config.trialsPerPoint = 100;
+    ModemSweep sweep(config);
+
+    std::vector<ModemSweep::Point> points;
+    for (int snr : {0, -6, -10, -12, -14, -16, -18, -20}) {
+        ModemSweep::Point point;
+        point.label = "snr " + std::to_string(snr) + " dB";
+        point.channel.snrDb = snr;
+        points.push_back(point);
+    }
+    for (double delayMs : {0.5, 2.0, 5.0}) {
+        ModemSweep::Point point;
+        point.label = "echo " + std::to_string(delayMs).substr(0, 3) + " ms x0.7";
+        point.channel.echoes = {{delayMs / 1000, 0.7}};
+        point.channel.snrDb = 0;
+        points.push_back(point);
+    }
+    for (double ppm : {100.0, 1000.0, 3000.0}) {
+        ModemSweep::Point point;
+        point.label = "drift " + std::to_string(static_cast<int>(ppm)) + " ppm";
+        point.channel.clockDriftPpm = ppm;
+        point.channel.snrDb = 0;
+        points.push_back(point);
+    }
+    for (double speed : {0.5, 1.5}) {
+        ModemSweep::Point point;
+        point.label = "walking " + std::to_string(speed).substr(0, 3) + " m/s";
+        point.channel.velocityMps = speed;
+        point.channel.snrDb = 0;
+        points.push_back(point);
+    }
+    // A second hub a few metres away, beaconing on the same carriers.
+    WaveformSynthesizer neighbour(48000, 15000.0, 1000.0, 480);
+    for (double gainDb : {-30.0, -20.0, -10.0}) {
+        ModemSweep::Point point;
+        point.label = "co-channel " + std::to_string(static_cast<int>(gainDb)) + " dB";
+        point.channel.transmitters = {{neighbour.synthesize("neighbouring hub"), gainDb, 240}};
+        point.channel.snrDb = 0;
+        points.push_back(point);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = sweep.run(points);
+    auto wallMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    sweep.report(std::cout, results);
+    std::cout << points.size() * config.trialsPerPoint << " trials in " << wallMs << " ms" << std::endl;
+
+    EXPECT_EQ(0u, results[0].bitErrors);  // 0 dB is comfortable for 480-sample frames
+    EXPECT_NEAR(100.0, results[0].goodputBps(config.payloadBytes), 1e-6);  // 480-sample bits: 100 bit/s raw
+    EXPECT_GT(results[7].bitErrorRate(), results[3].bitErrorRate());
+    EXPECT_GT(results[7].bitErrorRate(), 0.01);
+
+    // Rows 8-10 echo, 11-13 drift, 14-15 walking, 16-18 co-channel hub.
+    for (size_t row : {8, 9, 10, 11, 12, 13, 14, 16, 17, 18}) {
+        EXPECT_EQ(0u, results[row].bitErrors) << results[row].label;
+        EXPECT_EQ(config.trialsPerPoint, results[row].payloadsIntact) << results[row].label;
+    }
+    // A brisk walk slips the bit clock by more than the guard allows.
+    EXPECT_GT(results[15].bitErrors, 0u) << results[15].label;
+}
+
+TEST(ModemSweepTest, BadChannelThrowsOnCallingThread) {
+    ModemSweep::Config config;
+    config.trialsPerPoint = 4;
+    config.threads = 4;
+    std::vector<ModemSweep::Point> points(2);
+    points[1].label = "negative echo";
+    points[1].channel.echoes = {{-0.001, 0.5}};
+    EXPECT_THROW(ModemSweep(config).run(points), std::runtime_error);
+}
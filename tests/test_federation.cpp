@@ -0,0 +1,307 @@
+#include <gtest/gtest.h>
+#include "core/consistent_hash_ring.h"
+#include "network/federated_hub.h"
+#include "network/network_simulator.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Federation {
+    explicit Federation(size_t count, FederatedHub::Config config = FederatedHub::Config()) {
+        std::vector<FederatedHub::HubId> members;
+        for (size_t i = 0; i < count; ++i) {
+            members.push_back(network.addNode());
+        }
+        for (size_t a = 0; a < count; ++a) {
+            for (size_t b = a + 1; b < count; ++b) {
+                NetworkSimulator::LinkProfile satellite;
+                satellite.latencyTicks = 300;
+                network.connect(members[a], members[b], satellite);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            services.push_back(std::make_unique<HubService>());
+            hubs.push_back(std::make_unique<FederatedHub>(network, members[i], *services[i], members, config));
+        }
+    }
+
+    FederatedHub& hub(size_t i) { return *hubs[i]; }
+    HubService& service(size_t i) { return *services[i]; }
+
+    bool has(size_t i, const std::string& name) {
+        Listing listing;
+        return services[i]->findListing(name, listing);
+    }
+
+    // Finds a key whose preference list starts with `primary, replica`.
+    std::string keyOwnedBy(FederatedHub::HubId primary, FederatedHub::HubId replica) {
+        for (int i = 0;; ++i) {
+            std::string key = "item-" + std::to_string(i);
+            auto owners = hubs[0]->ownersOf(key);
+            if (owners[0] == primary && owners[1] == replica) {
+                return key;
+            }
+        }
+    }
+
+    NetworkSimulator network;
+    std::vector<std::unique_ptr<HubService>> services;
+    std::vector<std::unique_ptr<FederatedHub>> hubs;
+};
+
+auto expectOk(int& done) {
+    return [&done](IpcStatus status, const std::vector<uint8_t>&) {
+        EXPECT_EQ(IpcStatus::Ok, status);
+        ++done;
+    };
+}
+
+}  // namespace
+
+TEST(ConsistentHashRingTest, BalancesAndMovesFewKeys) {
+    ConsistentHashRing ring;
+    for (uint32_t node = 0; node < 4; ++node) {
+        ring.addNode(node);
+    }
+    const int keys = 40000;
+    std::vector<uint32_t> before;
+    std::map<uint32_t, int> load;
+    for (int i = 0; i < keys; ++i) {
+        before.push_back(ring.owner("key-" + std::to_string(i)));
+        ++load[before.back()];
+    }
+    for (const auto& entry : load) {
+        EXPECT_NEAR(keys / 4, entry.second, keys / 4 / 5);
+    }
+
+    ring.addNode(4);
+    int moved = 0;
+    for (int i = 0; i < keys; ++i) {
+        uint32_t owner = ring.owner("key-" + std::to_string(i));
+        if (owner != before[i]) {
+            EXPECT_EQ(4u, owner);  // keys only move to the newcomer
+            ++moved;
+        }
+    }
+    EXPECT_NEAR(keys / 5, moved, keys / 5 / 5);
+
+    auto owners = ring.preferenceList("key-1", 3);
+    ASSERT_EQ(3u, owners.size());
+    EXPECT_NE(owners[0], owners[1]);
+    EXPECT_NE(owners[1], owners[2]);
+    EXPECT_NE(owners[0], owners[2]);
+    EXPECT_THROW(ConsistentHashRing().owner("key"), std::runtime_error);
+}
+
+TEST(FederatedHubTest, ListingsLandOnTheirOwners) {
+    Federation federation(4);
+    int done = 0;
+    for (int i = 0; i < 200; ++i) {
+        Listing listing{"item-" + std::to_string(i), i + 1, 2.5};
+        federation.hub(i % 4).createListing(listing, expectOk(done));
+    }
+    federation.network.runUntilIdle();
+    EXPECT_EQ(200, done);
+
+    for (int i = 0; i < 200; ++i) {
+        std::string name = "item-" + std::to_string(i);
+        auto owners = federation.hub(0).ownersOf(name);
+        for (size_t h = 0; h < 4; ++h) {
+            bool owner = std::find(owners.begin(), owners.end(), h) != owners.end();
+            EXPECT_EQ(owner, federation.has(h, name)) << name << " on hub " << h;
+        }
+    }
+
+    std::string name = "item-7";
+    Listing found;
+    federation.hub(3).getListing(name, [&](IpcStatus status, const std::vector<uint8_t>& payload) {
+        ASSERT_EQ(IpcStatus::Ok, status);
+        IpcReader reader(payload.data(), payload.size());
+        int32_t quantity;
+        ASSERT_TRUE(reader.str(found.name) && reader.i32(quantity) && reader.f64(found.price));
+        found.quantity = quantity;
+    });
+    federation.network.runUntilIdle();
+    EXPECT_EQ(name, found.name);
+    EXPECT_EQ(8, found.quantity);
+}
+
+TEST(FederatedHubTest, PreorderForRemoteStockIsStoredAtOwner) {
+    Federation federation(3);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    federation.hub(1).createListing(Listing{name, 10, 4.0}, expectOk(done));
+    federation.hub(0).placePreorder(Preorder{name, 3}, expectOk(done));
+    federation.network.runUntilIdle();
+    EXPECT_EQ(2, done);
+
+    EXPECT_TRUE(federation.service(0).getPreorders().empty());
+    ASSERT_EQ(1u, federation.service(1).getPreorders().size());
+    ASSERT_EQ(1u, federation.service(2).getPreorders().size());
+    EXPECT_EQ(3, federation.service(1).getPreorders()[0].quantity);
+    EXPECT_EQ(1u, federation.hub(0).stats().requestsRemote);
+}
+
+TEST(FederatedHubTest, FailsOverToReplicaAndReplaysHints) {
+    FederatedHub::Config config;
+    config.requestTimeoutTicks = 1000;
+    Federation federation(3, config);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    federation.hub(0).createListing(Listing{name, 5, 1.0}, expectOk(done));
+    federation.network.runUntilIdle();
+
+    federation.network.setNodeUp(1, false);
+    federation.hub(0).updateListing(name, 9, 1.5, expectOk(done));
+    federation.network.runUntilIdle();
+    EXPECT_EQ(2, done);
+    EXPECT_EQ(1u, federation.hub(0).stats().failovers);
+    EXPECT_TRUE(federation.hub(0).isSuspected(1));
+    EXPECT_EQ(1u, federation.hub(2).stats().hintsQueued);
+
+    Listing listing;
+    ASSERT_TRUE(federation.service(2).findListing(name, listing));
+    EXPECT_EQ(9, listing.quantity);
+    ASSERT_TRUE(federation.service(1).findListing(name, listing));
+    EXPECT_EQ(5, listing.quantity);
+
+    // While suspected the primary is skipped without waiting for a timeout.
+    federation.hub(0).updateListing(name, 11, 1.5, expectOk(done));
+    federation.network.runUntilIdle();
+    EXPECT_EQ(1u, federation.hub(0).stats().failovers);
+
+    // Any traffic from the recovered primary flushes the replica's hints.
+    federation.network.setNodeUp(1, true);
+    federation.hub(1).getListing(federation.keyOwnedBy(2, 0), [](IpcStatus, const std::vector<uint8_t>&) {});
+    federation.network.runUntilIdle();
+    EXPECT_EQ(2u, federation.hub(2).stats().hintsDelivered);
+    ASSERT_TRUE(federation.service(1).findListing(name, listing));
+    EXPECT_EQ(11, listing.quantity);
+}
+
+TEST(FederatedHubTest, HintsAreKeptUntilAcknowledged) {
+    FederatedHub::Config config;
+    config.requestTimeoutTicks = 1000;
+    Federation federation(3, config);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    federation.network.setNodeUp(1, false);
+    federation.hub(0).createListing(Listing{name, 5, 1.0}, expectOk(done));
+    federation.network.runUntilIdle();
+    EXPECT_EQ(1, done);
+    EXPECT_EQ(1u, federation.hub(2).stats().hintsQueued);
+
+    // A malformed frame is not proof the primary is back.
+    federation.network.setNodeUp(1, true);
+    federation.network.send(1, 2, {1, 0});
+    federation.network.runUntilIdle();
+    EXPECT_TRUE(federation.hub(2).isSuspected(1));
+
+    // The primary speaks, then drops out again before the replay arrives.
+    federation.hub(1).getListing(federation.keyOwnedBy(2, 0), [](IpcStatus, const std::vector<uint8_t>&) {});
+    federation.network.runFor(500);
+    EXPECT_FALSE(federation.hub(2).isSuspected(1));
+    federation.network.setNodeUp(1, false);
+    federation.network.runUntilIdle();
+    EXPECT_EQ(0u, federation.hub(2).stats().hintsDelivered);
+    EXPECT_FALSE(federation.has(1, name));
+
+    // Its own request timed out meanwhile, so wait out its suspicion of hub 2.
+    federation.network.setNodeUp(1, true);
+    federation.network.runFor(config.suspectTicks);
+    federation.hub(1).getListing(federation.keyOwnedBy(2, 0), [](IpcStatus, const std::vector<uint8_t>&) {});
+    federation.network.runUntilIdle();
+    EXPECT_EQ(1u, federation.hub(2).stats().hintsDelivered);
+    EXPECT_TRUE(federation.has(1, name));
+}
+
+TEST(FederatedHubTest, ReplicatedWritesSurviveALostFrame) {
+    FederatedHub::Config config;
+    config.requestTimeoutTicks = 1000;
+    Federation federation(3, config);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    // The replica is down but not suspected, so the replicate frame is lost.
+    federation.network.setNodeUp(2, false);
+    federation.hub(0).createListing(Listing{name, 5, 1.0}, expectOk(done));
+    federation.network.runUntilIdle();
+    EXPECT_EQ(1, done);
+    EXPECT_FALSE(federation.has(2, name));
+
+    federation.network.setNodeUp(2, true);
+    federation.network.runFor(config.requestTimeoutTicks);
+    federation.hub(2).getListing(federation.keyOwnedBy(1, 0), [](IpcStatus, const std::vector<uint8_t>&) {});
+    federation.network.runUntilIdle();
+    EXPECT_TRUE(federation.has(2, name));
+    EXPECT_EQ(0u, federation.hub(1).stats().hintsQueued);
+}
+
+TEST(FederatedHubTest, FailoverWritesAreUpserts) {
+    FederatedHub::Config config;
+    config.requestTimeoutTicks = 1000;
+    Federation federation(3, config);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    federation.hub(0).createListing(Listing{name, 5, 1.0}, expectOk(done));
+    federation.network.runUntilIdle();
+    ASSERT_TRUE(federation.has(2, name));
+
+    // A retried create that fails over lands on a replica already holding it.
+    federation.network.setNodeUp(1, false);
+    federation.hub(0).createListing(Listing{name, 7, 2.0}, expectOk(done));
+    federation.network.runUntilIdle();
+    federation.network.setNodeUp(1, true);
+    federation.hub(1).getListing(federation.keyOwnedBy(2, 0), [](IpcStatus, const std::vector<uint8_t>&) {});
+    federation.network.runUntilIdle();
+    EXPECT_EQ(2, done);
+
+    for (size_t i : {1, 2}) {
+        auto listings = federation.service(i).getListings();
+        ASSERT_EQ(1u, listings.size()) << "hub " << i;
+        EXPECT_EQ(7, listings[0].quantity) << "hub " << i;
+    }
+}
+
+TEST(FederatedHubTest, HintsAreCappedPerHub) {
+    FederatedHub::Config config;
+    config.requestTimeoutTicks = 1000;
+    config.maxHintsPerHub = 2;
+    Federation federation(3, config);
+    std::string name = federation.keyOwnedBy(1, 2);
+    int done = 0;
+    federation.network.setNodeUp(1, false);
+    for (int quantity = 1; quantity <= 5; ++quantity) {
+        federation.hub(0).updateListing(name, quantity, 1.0, expectOk(done));
+        federation.network.runUntilIdle();
+    }
+    EXPECT_EQ(5, done);
+    EXPECT_EQ(2u, federation.hub(2).stats().hintsQueued);
+    EXPECT_EQ(3u, federation.hub(2).stats().hintsDropped);
+}
+
+TEST(FederatedHubTest, BatchesMessagesPerPeer) {
+    Federation federation(4);
+    int done = 0;
+    const int writes = 2000;
+    for (int i = 0; i < writes; ++i) {
+        federation.hub(i % 4).createListing(Listing{"bulk-" + std::to_string(i), 1, 1.0}, expectOk(done));
+    }
+    federation.network.runUntilIdle();
+    EXPECT_EQ(writes, done);
+
+    uint64_t messages = 0;
+    uint64_t frames = 0;
+    for (size_t h = 0; h < 4; ++h) {
+        messages += federation.hub(h).stats().messagesSent;
+        frames += federation.hub(h).stats().framesSent;
+    }
+    std::cout << "messages " << messages << "  frames " << frames << "  messages/frame "
+              << static_cast<double>(messages) / frames << std::endl;
+    EXPECT_EQ(frames, federation.network.stats().sent);
+    EXPECT_GT(messages, frames * 20);
+}
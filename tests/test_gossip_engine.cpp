@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+#include "core/rotating_bloom_filter.h"
+#include "network/gossip_engine.h"
+#include "network/network_simulator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct Mesh {
+    explicit Mesh(size_t nodes, GossipEngine::Config config = GossipEngine::Config()) : received(nodes, false) {
+        for (size_t i = 0; i < nodes; ++i) {
+            network.addNode();
+        }
+        for (size_t i = 0; i < nodes; ++i) {
+            engines.push_back(std::make_unique<GossipEngine>(network, static_cast<NetworkSimulator::NodeId>(i), config));
+            engines.back()->setKeyHandler([this, i](const GossipEngine::KeyAnnouncement&, unsigned hops) {
+                received[i] = true;
+                lastDelivery = network.now();
+                maxHops = std::max(maxHops, hops);
+            });
+        }
+    }
+
+    // One shared key per link, as left behind by pairwise key exchange.
+    void keyLinks() {
+        for (NetworkSimulator::NodeId a = 0; a < network.nodeCount(); ++a) {
+            for (NetworkSimulator::NodeId b : network.neighbors(a)) {
+                if (a < b) {
+                    auto key = EncryptionModule::generateKey();
+                    engines[a]->setPeerKey(b, key);
+                    engines[b]->setPeerKey(a, key);
+                }
+            }
+        }
+    }
+
+    size_t coverage() const {
+        size_t count = 0;
+        for (bool r : received) {
+            count += r ? 1 : 0;
+        }
+        return count;
+    }
+
+    NetworkSimulator network;
+    std::vector<std::unique_ptr<GossipEngine>> engines;
+    std::vector<bool> received;
+    uint64_t lastDelivery = 0;
+    unsigned maxHops = 0;
+};
+
+const std::vector<uint8_t> kSessionKey(32, 0xAB);
+
+}  // namespace
+
+TEST(RotatingBloomFilterTest, RemembersForOneGeneration) {
+    RotatingBloomFilter filter(4096, 5);
+    EXPECT_TRUE(filter.insertIfAbsent(42));
+    EXPECT_FALSE(filter.insertIfAbsent(42));
+    filter.rotate();
+    EXPECT_TRUE(filter.contains(42));
+    filter.rotate();
+    EXPECT_FALSE(filter.contains(42));
+
+    size_t falsePositives = 0;
+    for (uint64_t id = 0; id < filter.capacity(); ++id) {
+        filter.insert(id);
+    }
+    for (uint64_t id = 1000000; id < 1010000; ++id) {
+        falsePositives += filter.contains(id) ? 1 : 0;
+    }
+    EXPECT_LT(falsePositives, 200u);
+}
+
+TEST(GossipEngineTest, HopLimitBoundsRelaying) {
+    GossipEngine::Config config;
+    config.hopLimit = 3;
+    Mesh mesh(6, config);
+    for (NetworkSimulator::NodeId i = 0; i + 1 < 6; ++i) {
+        mesh.network.connect(i, i + 1);
+    }
+    mesh.keyLinks();
+
+    mesh.engines[0]->announce(kSessionKey);
+    mesh.network.runUntilIdle();
+
+    EXPECT_TRUE(mesh.received[3]);
+    EXPECT_FALSE(mesh.received[4]);
+    EXPECT_FALSE(mesh.received[5]);
+    EXPECT_EQ(3u, mesh.maxHops);
+}
+
+TEST(GossipEngineTest, DeliversKeyOnceDespiteCycles) {
+    Mesh mesh(4);
+    for (NetworkSimulator::NodeId a = 0; a < 4; ++a) {
+        for (NetworkSimulator::NodeId b = a + 1; b < 4; ++b) {
+            mesh.network.connect(a, b);
+        }
+    }
+    mesh.keyLinks();
+    std::vector<uint8_t> delivered;
+    mesh.engines[3]->setKeyHandler(
+        [&](const GossipEngine::KeyAnnouncement& announcement, unsigned) { delivered = announcement.key; });
+
+    uint64_t id = mesh.engines[0]->announce(kSessionKey);
+    mesh.network.runUntilIdle();
+
+    EXPECT_EQ(kSessionKey, delivered);
+    uint64_t received = 0;
+    uint64_t duplicates = 0;
+    for (auto& engine : mesh.engines) {
+        EXPECT_LE(engine->stats().received, 1u);
+        received += engine->stats().received;
+        duplicates += engine->stats().duplicates;
+    }
+    EXPECT_EQ(3u, received);  // everyone but the origin
+    EXPECT_GT(duplicates, 0u);
+    EXPECT_NE(0u, id);
+}
+
+TEST(GossipEngineTest, RejectsBatchesUnderWrongKey) {
+    Mesh mesh(2);
+    mesh.network.connect(0, 1);
+    mesh.engines[0]->setPeerKey(1, EncryptionModule::generateKey());
+    mesh.engines[1]->setPeerKey(0, EncryptionModule::generateKey());
+
+    mesh.engines[0]->announce(kSessionKey);
+    mesh.network.runUntilIdle();
+
+    EXPECT_FALSE(mesh.received[1]);
+    EXPECT_EQ(1u, mesh.engines[1]->stats().batchesRejected);
+}
+
+TEST(GossipEngineTest, FailedSendsAreNotCountedAsRelayed) {
+    Mesh mesh(2);
+    mesh.network.connect(0, 1);
+    mesh.keyLinks();
+    mesh.network.setNodeUp(0, false);
+
+    mesh.engines[0]->announce(kSessionKey);
+    mesh.network.runUntilIdle();
+
+    EXPECT_EQ(0u, mesh.engines[0]->stats().batchesSent);
+    EXPECT_EQ(0u, mesh.engines[0]->stats().relayed);
+}
+
+TEST(GossipEngineTest, RestartDoesNotReuseBatchNonces) {
+    NetworkSimulator network;
+    network.addNode();
+    network.addNode();
+    network.connect(0, 1);
+    auto key = EncryptionModule::generateKey();
+    std::vector<uint64_t> batches;
+    for (int run = 0; run < 2; ++run) {
+        GossipEngine engine(network, 0);
+        engine.setPeerKey(1, key);
+        // The batch counter travels in clear at bytes 5-12 of the header.
+        network.setReceiver(1, [&](NetworkSimulator::NodeId, const std::vector<uint8_t>& frame) {
+            uint64_t batch;
+            std::memcpy(&batch, frame.data() + 5, sizeof(batch));
+            batches.push_back(batch);
+        });
+        engine.announce(kSessionKey);
+        network.runUntilIdle();
+    }
+    ASSERT_EQ(2u, batches.size());
+    EXPECT_NE(batches[0], batches[1]);
+}
+
+TEST(GossipEngineTest, ReplayAfterCountRotationsIsRefused) {
+    GossipEngine::Config config;
+    config.bloomBits = 4096;
+    config.peerRatePerTick = 1e6;
+    config.peerBurst = 1e6;
+    config.maxQueuedPerPeer = 1 << 20;
+    config.batchTicks = 1;
+    Mesh mesh(3, config);
+    mesh.network.connect(0, 1);
+    mesh.network.connect(0, 2);
+    // Node 2 taps everything node 0 sends under the key it shares with 1.
+    auto key = EncryptionModule::generateKey();
+    mesh.engines[0]->setPeerKey(1, key);
+    mesh.engines[1]->setPeerKey(0, key);
+    mesh.engines[0]->setPeerKey(2, key);
+    std::vector<uint8_t> firstFrame;
+    mesh.network.setReceiver(2, [&](NetworkSimulator::NodeId, const std::vector<uint8_t>& frame) {
+        if (firstFrame.empty()) {
+            firstFrame = frame;
+        }
+    });
+    size_t deliveries = 0;
+    mesh.engines[1]->setKeyHandler([&](const GossipEngine::KeyAnnouncement&, unsigned) { ++deliveries; });
+
+    // Well over two generations' worth of ids, all inside one dedup window.
+    size_t total = 3 * RotatingBloomFilter(config.bloomBits, config.bloomHashes).capacity();
+    for (size_t sent = 0; sent < total; sent += 50) {
+        for (size_t i = sent; i < std::min(total, sent + 50); ++i) {
+            mesh.engines[0]->announce(kSessionKey);
+        }
+        mesh.network.runFor(1);
+    }
+    mesh.network.runUntilIdle();
+    // A few fresh ids are lost to false positives near capacity, none to age.
+    const GossipEngine::Stats& stats = mesh.engines[1]->stats();
+    ASSERT_EQ(total, deliveries + stats.duplicates);
+    ASSERT_EQ(0u, stats.expired);
+    ASSERT_FALSE(firstFrame.empty());
+    ASSERT_LT(mesh.network.now(), config.dedupWindowTicks);
+
+    // The early ids have rotated out of the filter, so their age must stop them.
+    mesh.network.send(0, 1, firstFrame);
+    size_t before = deliveries;
+    mesh.network.runUntilIdle();
+    EXPECT_EQ(before, deliveries);
+    EXPECT_GT(stats.expired, 0u);
+}
+
+TEST(GossipEngineTest, RateLimitSpreadsBurstsAndBatches) {
+    GossipEngine::Config config;
+    config.peerRatePerTick = 1.0;
+    config.peerBurst = 10.0;
+    config.batchTicks = 1;
+    Mesh mesh(2, config);
+    mesh.network.connect(0, 1);
+    mesh.keyLinks();
+    size_t deliveries = 0;
+    mesh.engines[1]->setKeyHandler([&](const GossipEngine::KeyAnnouncement&, unsigned) { ++deliveries; });
+
+    for (int i = 0; i < 100; ++i) {
+        mesh.engines[0]->announce(kSessionKey);
+    }
+    uint64_t ticks = mesh.network.runUntilIdle();
+
+    EXPECT_EQ(100u, deliveries);
+    EXPECT_GE(ticks, 90u);  // 10 in the first burst, then one per tick
+    EXPECT_LT(mesh.engines[0]->stats().batchesSent, 100u);
+}
+
+TEST(GossipEngineTest, ScalingBenchmark) {
+    std::cout << "nodes  coverage  convergence_ticks  max_hops  batches/node  bytes/node  wall_ms" << std::endl;
+    for (size_t nodes : {1000, 2000, 5000, 10000}) {
+        auto start = std::chrono::steady_clock::now();
+        Mesh mesh(nodes);
+        NetworkSimulator::LinkProfile wifi;
+        wifi.latencyTicks = 5;
+        wifi.jitterTicks = 10;
+        wifi.lossRate = 0.01;
+        mesh.network.connectRandomMesh(8, wifi);
+        mesh.keyLinks();
+
+        mesh.engines[0]->announce(kSessionKey);
+        mesh.network.runUntilIdle();
+        auto wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+        const auto& stats = mesh.network.stats();
+        std::cout << nodes << "  " << static_cast<double>(mesh.coverage()) / (nodes - 1) << "  " << mesh.lastDelivery
+                  << "  " << mesh.maxHops << "  " << static_cast<double>(stats.sent) / nodes << "  "
+                  << static_cast<double>(stats.bytes) / nodes << "  " << wallMs.count() << std::endl;
+        EXPECT_GE(mesh.coverage(), (nodes - 1) * 99 / 100);
+        EXPECT_LE(static_cast<double>(stats.sent) / nodes, 6.0);
+    }
+}
@@ -0,0 +1,294 @@
+#include <gtest/gtest.h>
+#include "business/hub_service.h"
+#include "network/http_server.h"
+#include "network/hub_http_api.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        ASSERT_GT(n, 0);
+        sent += static_cast<size_t>(n);
+    }
+}
+
+// Reads exactly one response (headers plus Content-Length body).
+std::string readResponse(int fd, std::string& pending) {
+    char buffer[4096];
+    for (;;) {
+        size_t headerEnd = pending.find("\r\n\r\n");
+        if (headerEnd != std::string::npos) {
+            size_t lengthAt = pending.find("Content-Length: ");
+            size_t length = std::stoul(pending.substr(lengthAt + 16));
+            size_t total = headerEnd + 4 + length;
+            if (pending.size() >= total) {
+                std::string response = pending.substr(0, total);
+                pending.erase(0, total);
+                return response;
+            }
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            return std::string();
+        }
+        pending.append(buffer, static_cast<size_t>(n));
+    }
+}
+
+std::string request(const std::string& method, const std::string& path, const std::string& body = "") {
+    return method + " " + path + " HTTP/1.1\r\nHost: hub\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+
+}  // namespace
+
+class HttpServerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        HttpServer::Config config;
+        config.bindAddress = "127.0.0.1";
+        config.port = 0;
+        config.reactors = 2;
+        config.maxConnections = 2048;
+        server = std::make_unique<HttpServer>(config, makeHubHttpHandler(service));
+        ASSERT_TRUE(server->start());
+    }
+
+    std::string roundTrip(const std::string& raw) {
+        int fd = connectTo(server->port());
+        EXPECT_GE(fd, 0);
+        sendAll(fd, raw);
+        std::string pending;
+        std::string response = readResponse(fd, pending);
+        ::close(fd);
+        return response;
+    }
+
+    HubService service;
+    std::unique_ptr<HttpServer> server;
+};
+
+TEST_F(HttpServerTest, CreateAndListListings) {
+    std::string created = roundTrip(request("POST", "/listings", R"({"name":"Water Bottles","quantity":100,"price":1.5})"));
+    EXPECT_EQ(0u, created.find("HTTP/1.1 201"));
+
+    std::string listed = roundTrip(request("GET", "/listings"));
+    EXPECT_EQ(0u, listed.find("HTTP/1.1 200"));
+    EXPECT_NE(std::string::npos, listed.find(R"([{"name":"Water Bottles","quantity":100,"price":1.5}])"));
+}
+
+TEST_F(HttpServerTest, UpdateListingAndCancelPreorder) {
+    service.createListing({"Blankets", 10, 5.0});
+    EXPECT_EQ(0u, roundTrip(request("PUT", "/listings/Blankets", R"({"quantity":4,"price":6})")).find("HTTP/1.1 200"));
+    EXPECT_EQ(4, service.getListings()[0].quantity);
+    EXPECT_EQ(0u, roundTrip(request("PUT", "/listings/Tents", R"({"quantity":4,"price":6})")).find("HTTP/1.1 404"));
+
+    EXPECT_EQ(0u, roundTrip(request("POST", "/preorders", R"({"itemName":"Water Bottles","quantity":2})")).find("HTTP/1.1 201"));
+    EXPECT_EQ(0u, roundTrip(request("DELETE", "/preorders/Water%20Bottles")).find("HTTP/1.1 204"));
+    EXPECT_TRUE(service.getPreorders().empty());
+}
+
+TEST_F(HttpServerTest, RejectsBadRequests) {
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", R"({"name":"x"})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("GET", "/nowhere")).find("HTTP/1.1 404"));
+    EXPECT_EQ(0u, roundTrip("garbage\r\n\r\n").find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", std::string(8192, 'x'))).find("HTTP/1.1 413"));
+}
+
+TEST_F(HttpServerTest, RejectsAmbiguousFraming) {
+    std::string body = R"({"itemName":"x","quantity":1})";
+    std::string smuggled = request("POST", "/preorders", body);
+    std::string chunked = "POST /preorders HTTP/1.1\r\nHost: hub\r\nTransfer-Encoding: chunked\r\n\r\n" +
+                          std::to_string(smuggled.size()) + "\r\n" + smuggled + "\r\n0\r\n\r\n";
+    int fd = connectTo(server->port());
+    ASSERT_GE(fd, 0);
+    sendAll(fd, chunked);
+    std::string pending;
+    EXPECT_EQ(0u, readResponse(fd, pending).find("HTTP/1.1 400"));
+    // The connection is closed rather than parsing chunk data as a request.
+    EXPECT_EQ("", readResponse(fd, pending));
+    ::close(fd);
+
+    std::string conflicting = "POST /preorders HTTP/1.1\r\nHost: hub\r\nContent-Length: 0\r\nContent-Length: " +
+                              std::to_string(body.size()) + "\r\n\r\n" + body;
+    EXPECT_EQ(0u, roundTrip(conflicting).find("HTTP/1.1 400"));
+    std::string repeated = "POST /preorders HTTP/1.1\r\nHost: hub\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\nContent-Length: " + std::to_string(body.size()) +
+                           "\r\n\r\n" + body;
+    EXPECT_EQ(0u, roundTrip(repeated).find("HTTP/1.1 201"));
+    EXPECT_EQ(1u, service.getPreorders().size());
+}
+
+TEST_F(HttpServerTest, RejectsOutOfRangeNumbersAndBadEscapes) {
+    for (const char* quantity : {"nan", "inf", "-inf", "1e20", "-1", "2.5", "2147483648"}) {
+        std::string body = std::string(R"({"name":"x","quantity":)") + quantity + R"(,"price":1})";
+        EXPECT_EQ(0u, roundTrip(request("POST", "/listings", body)).find("HTTP/1.1 400")) << quantity;
+        body = std::string(R"({"itemName":"x","quantity":)") + quantity + "}";
+        EXPECT_EQ(0u, roundTrip(request("POST", "/preorders", body)).find("HTTP/1.1 400")) << quantity;
+    }
+    EXPECT_EQ(0u, roundTrip(request("POST", "/preorders", R"({"itemName":"x","quantity":0})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", R"({"name":"x","quantity":1,"price":nan})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", R"({"name":"x","quantity":1,"price":-1})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", R"({"name":"x","quantity":2147483647,"price":0})")).find("HTTP/1.1 201"));
+
+    service.createListing({"Blankets", 10, 5.0});
+    EXPECT_EQ(0u, roundTrip(request("PUT", "/listings/Blankets", R"({"quantity":1e20,"price":6})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("PUT", "/listings/Blank%zzets", R"({"quantity":4,"price":6})")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("DELETE", "/preorders/item%00")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("DELETE", "/preorders/item%4")).find("HTTP/1.1 400"));
+    EXPECT_EQ(10, service.getListings()[1].quantity);
+}
+
+TEST_F(HttpServerTest, DecodesEscapesTheWayTheyAreEncoded) {
+    std::string body = R"({"name":"caf\u00e9 \ud83c\udf75 \u0001\/\"","quantity":1,"price":1})";
+    EXPECT_EQ(0u, roundTrip(request("POST", "/listings", body)).find("HTTP/1.1 201"));
+    ASSERT_EQ(1u, service.getListings().size());
+    EXPECT_EQ("caf\xc3\xa9 \xf0\x9f\x8d\xb5 \x01/\"", service.getListings()[0].name);
+    EXPECT_NE(std::string::npos, roundTrip(request("GET", "/listings")).find("\"name\":\"caf\xc3\xa9 \xf0\x9f\x8d\xb5 \\u0001/\\\"\""));
+
+    for (const char* name : {R"(\ud83c)", R"(\udf75)", R"(\ud83cx)", R"(\u00zz)", R"(\u0000)", R"(\q)", R"(\u12)"}) {
+        body = std::string(R"({"name":"x)") + name + R"(","quantity":1,"price":1})";
+        EXPECT_EQ(0u, roundTrip(request("POST", "/listings", body)).find("HTTP/1.1 400")) << name;
+    }
+
+    service.placePreorder({"C++ Books", 2});
+    EXPECT_EQ(0u, roundTrip(request("DELETE", "/preorders/C++%20Books")).find("HTTP/1.1 204"));
+    EXPECT_TRUE(service.getPreorders().empty());
+}
+
+TEST_F(HttpServerTest, ListsArePaged) {
+    for (int i = 0; i < 250; ++i) {
+        service.createListing({"item-" + std::to_string(i), i, 1.0});
+    }
+    std::string firstPage = roundTrip(request("GET", "/listings"));
+    EXPECT_NE(std::string::npos, firstPage.find("X-Total-Count: 250\r\n"));
+    EXPECT_NE(std::string::npos, firstPage.find(R"("name":"item-99")"));
+    EXPECT_EQ(std::string::npos, firstPage.find(R"("name":"item-100")"));
+
+    std::string lastPage = roundTrip(request("GET", "/listings?offset=240&limit=50"));
+    EXPECT_NE(std::string::npos, lastPage.find(R"([{"name":"item-240")"));
+    EXPECT_NE(std::string::npos, lastPage.find(R"("name":"item-249","quantity":249,"price":1}])"));
+    EXPECT_NE(std::string::npos, roundTrip(request("GET", "/listings?offset=300")).find("\r\n\r\n[]"));
+
+    EXPECT_EQ(0u, roundTrip(request("GET", "/listings?limit=5000")).find("HTTP/1.1 400"));
+    EXPECT_EQ(0u, roundTrip(request("GET", "/preorders?offset=-1")).find("HTTP/1.1 400"));
+}
+
+TEST_F(HttpServerTest, KeepAliveAndPipelining) {
+    int fd = connectTo(server->port());
+    ASSERT_GE(fd, 0);
+    std::string batch;
+    for (int i = 0; i < 50; ++i) {
+        batch += request("POST", "/preorders", R"({"itemName":"item","quantity":)" + std::to_string(i + 1) + "}");
+    }
+    sendAll(fd, batch);
+    std::string pending;
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(0u, readResponse(fd, pending).find("HTTP/1.1 201")) << "response " << i;
+    }
+    ::close(fd);
+    EXPECT_EQ(50u, service.getPreorders().size());
+}
+
+TEST_F(HttpServerTest, DeferredWorkDoesNotStallTheReactor) {
+    std::mutex mutex;
+    std::condition_variable released;
+    bool release = false;
+    HttpServer::Config config;
+    config.bindAddress = "127.0.0.1";
+    config.port = 0;
+    config.reactors = 1;
+    config.maxConnections = 16;
+    HttpServer slow(config, [&](const HttpRequest& request, HttpResponse& response) {
+        if (request.path != "/slow") {
+            response.body = "{}";
+            return;
+        }
+        response.deferred = [&](HttpResponse& deferred) {
+            std::unique_lock<std::mutex> lock(mutex);
+            released.wait(lock, [&] { return release; });
+            deferred.body = "{\"slow\":true}";
+        };
+    });
+    ASSERT_TRUE(slow.start());
+
+    int blocked = connectTo(slow.port());
+    ASSERT_GE(blocked, 0);
+    sendAll(blocked, request("GET", "/slow") + request("GET", "/fast"));
+
+    // The only reactor keeps serving other connections while the work waits.
+    int other = connectTo(slow.port());
+    ASSERT_GE(other, 0);
+    sendAll(other, request("GET", "/fast"));
+    std::string otherPending;
+    EXPECT_EQ(0u, readResponse(other, otherPending).find("HTTP/1.1 200"));
+    ::close(other);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        release = true;
+    }
+    released.notify_all();
+    // Pipelined responses keep their order behind the deferred one.
+    std::string pending;
+    EXPECT_NE(std::string::npos, readResponse(blocked, pending).find("{\"slow\":true}"));
+    EXPECT_EQ(0u, readResponse(blocked, pending).find("HTTP/1.1 200"));
+    ::close(blocked);
+}
+
+TEST_F(HttpServerTest, ManyConcurrentClients) {
+    const int clients = 500;
+    std::vector<int> fds;
+    for (int i = 0; i < clients; ++i) {
+        int fd = connectTo(server->port());
+        ASSERT_GE(fd, 0) << "client " << i;
+        fds.push_back(fd);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    const int rounds = 10;
+    for (int round = 0; round < rounds; ++round) {
+        for (int fd : fds) {
+            sendAll(fd, request("GET", "/health"));
+        }
+        for (int fd : fds) {
+            std::string pending;
+            ASSERT_EQ(0u, readResponse(fd, pending).find("HTTP/1.1 200"));
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_EQ(static_cast<size_t>(clients), server->activeConnections());
+
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::cout << clients * rounds << " requests over " << clients << " connections in " << us
+              << " microseconds (" << (clients * rounds * 1e6 / us) << " req/s)" << std::endl;
+}
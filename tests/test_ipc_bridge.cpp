@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include "business/hub_service.h"
+#include "ipc/hub_ipc.h"
+#include "metrics/metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+class IpcBridgeTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string name = "test-" + std::to_string(::getpid());
+        auto serverChannel = ShmChannel::create(name, 512, 16);
+        ASSERT_NE(nullptr, serverChannel);
+        server = std::make_unique<HubIpcServer>(service, std::move(serverChannel));
+        serverThread = std::thread([this] { server->serve(running); });
+
+        auto clientChannel = ShmChannel::connect(name);
+        ASSERT_NE(nullptr, clientChannel);
+        client = std::make_unique<HubIpcClient>(std::move(clientChannel));
+    }
+
+    void TearDown() override {
+        running = false;
+        if (server) {
+            server->stop();
+        }
+        if (serverThread.joinable()) {
+            serverThread.join();
+        }
+    }
+
+    HubService service;
+    std::atomic<bool> running{true};
+    std::unique_ptr<HubIpcServer> server;
+    std::thread serverThread;
+    std::unique_ptr<HubIpcClient> client;
+};
+
+TEST_F(IpcBridgeTest, CreateAndListListings) {
+    EXPECT_EQ(IpcStatus::Ok, client->createListing({"Water Bottles", 100, 1.5}));
+    EXPECT_EQ(IpcStatus::Ok, client->createListing({"Blankets", 20, 12.0}));
+
+    std::vector<Listing> listings;
+    uint32_t total = 0;
+    ASSERT_EQ(IpcStatus::Ok, client->listListings(0, listings, total));
+    EXPECT_EQ(2u, total);
+    ASSERT_EQ(2u, listings.size());
+    EXPECT_EQ("Water Bottles", listings[0].name);
+    EXPECT_EQ(100, listings[0].quantity);
+    EXPECT_DOUBLE_EQ(12.0, listings[1].price);
+}
+
+TEST_F(IpcBridgeTest, ListingsArePagedToSlotSize) {
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(IpcStatus::Ok, client->createListing({"item-" + std::to_string(i), i, 1.0}));
+    }
+
+    std::vector<Listing> listings;
+    uint32_t total = 0;
+    while (true) {
+        size_t before = listings.size();
+        ASSERT_EQ(IpcStatus::Ok, client->listListings(static_cast<uint32_t>(before), listings, total));
+        if (listings.size() == before || listings.size() == total) {
+            break;
+        }
+    }
+    ASSERT_EQ(100u, listings.size());
+    EXPECT_EQ("item-99", listings.back().name);
+}
+
+TEST_F(IpcBridgeTest, OversizedEntryIsTruncatedInsteadOfStallingPaging) {
+    // Too long for a 512-byte slot; created directly since no request could carry it.
+    ASSERT_TRUE(service.createListing({std::string(600, 'x'), 1, 1.0}));
+    ASSERT_TRUE(service.createListing({"Blankets", 20, 12.0}));
+
+    std::vector<Listing> listings;
+    uint32_t total = 0;
+    ASSERT_EQ(IpcStatus::Ok, client->listListings(0, listings, total));
+    EXPECT_EQ(2u, total);
+    ASSERT_EQ(1u, listings.size());
+    EXPECT_LT(listings[0].name.size(), 600u);
+    EXPECT_EQ(std::string(listings[0].name.size(), 'x'), listings[0].name);
+
+    ASSERT_EQ(IpcStatus::Ok, client->listListings(1, listings, total));
+    ASSERT_EQ(2u, listings.size());
+    EXPECT_EQ("Blankets", listings[1].name);
+}
+
+TEST_F(IpcBridgeTest, StalledClientDoesNotWedgeShutdown) {
+    Counter& dropped = MetricsRegistry::instance().counter("ipc_responses_dropped");
+    uint64_t droppedBefore = dropped.value();
+
+    // One more request than the response ring holds, and never poll.
+    std::vector<uint8_t> payload;
+    IpcWriter(payload).u32(0);
+    uint32_t requestId;
+    for (int posted = 0; posted < 17;) {
+        posted += client->post(IpcOp::ListListings, payload, requestId) ? 1 : 0;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    auto start = std::chrono::steady_clock::now();
+    running = false;
+    server->stop();
+    serverThread.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    EXPECT_EQ(droppedBefore + 1, dropped.value());
+}
+
+TEST_F(IpcBridgeTest, UpdateAndCancelReportNotFound) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str("Missing");
+    writer.i32(1);
+    writer.f64(1.0);
+    std::vector<uint8_t> response;
+    EXPECT_EQ(IpcStatus::NotFound, client->call(IpcOp::UpdateListing, payload, response));
+
+    EXPECT_EQ(IpcStatus::Ok, client->placePreorder({"Water Bottles", 2}));
+    payload.clear();
+    IpcWriter(payload).str("Water Bottles");
+    EXPECT_EQ(IpcStatus::Ok, client->call(IpcOp::CancelPreorder, payload, response));
+    EXPECT_EQ(IpcStatus::NotFound, client->call(IpcOp::CancelPreorder, payload, response));
+    EXPECT_TRUE(service.getPreorders().empty());
+}
+
+TEST_F(IpcBridgeTest, RejectsMalformedAndUnknownRequests) {
+    std::vector<uint8_t> response;
+    std::vector<uint8_t> truncated = {5, 0};
+    EXPECT_EQ(IpcStatus::BadRequest, client->call(IpcOp::CreateListing, truncated, response));
+    EXPECT_EQ(IpcStatus::UnknownOp, client->call(static_cast<IpcOp>(99), {}, response));
+
+    std::vector<uint8_t> huge(4096, 'x');
+    EXPECT_EQ(IpcStatus::TooLarge, client->call(IpcOp::SatelliteSend, huge, response));
+}
+
+TEST_F(IpcBridgeTest, RejectsWritesTheHttpApiWouldReject) {
+    EXPECT_EQ(IpcStatus::BadRequest, client->createListing({"Water Bottles", 1, std::nan("")}));
+    EXPECT_EQ(IpcStatus::BadRequest, client->createListing({"Water Bottles", 1, std::numeric_limits<double>::infinity()}));
+    EXPECT_EQ(IpcStatus::BadRequest, client->createListing({"Water Bottles", -1, 1.0}));
+    EXPECT_EQ(IpcStatus::BadRequest, client->placePreorder({"Water Bottles", 0}));
+    EXPECT_EQ(IpcStatus::BadRequest, client->placePreorder({"Water Bottles", -5}));
+    EXPECT_TRUE(service.getListings().empty());
+    EXPECT_TRUE(service.getPreorders().empty());
+
+    ASSERT_EQ(IpcStatus::Ok, client->createListing({"Blankets", 20, 12.0}));
+    std::vector<uint8_t> payload, response;
+    IpcWriter writer(payload);
+    writer.str("Blankets");
+    writer.i32(20);
+    writer.f64(std::nan(""));
+    EXPECT_EQ(IpcStatus::BadRequest, client->call(IpcOp::UpdateListing, payload, response));
+    EXPECT_EQ(12.0, service.getListings()[0].price);
+}
+
+TEST(IpcExecutorTest, ChannelLessServerOnlyHandles) {
+    HubService service;
+    HubIpcServer executor(service, nullptr);
+    executor.stop();
+    std::atomic<bool> running{true};
+    executor.serve(running);
+
+    std::vector<uint8_t> request(sizeof(IpcHeader));
+    IpcHeader header{7, static_cast<uint16_t>(IpcOp::ListListings), 0, 0};
+    std::memcpy(request.data(), &header, sizeof(header));
+    std::vector<uint8_t> response;
+    executor.handle(request, response);
+    ASSERT_GE(response.size(), sizeof(IpcHeader));
+    std::memcpy(&header, response.data(), sizeof(header));
+    EXPECT_EQ(7u, header.requestId);
+}
+
+TEST_F(IpcBridgeTest, SatelliteOpsFailWhenOffline) {
+    std::vector<uint8_t> response;
+    std::vector<uint8_t> transaction = {'t', 'x'};
+    EXPECT_EQ(IpcStatus::Failed, client->call(IpcOp::SubmitTransaction, transaction, response));
+    EXPECT_EQ(0u, service.transactionsSubmitted());
+}
+
+TEST_F(IpcBridgeTest, PipelinedRequestsAllComplete) {
+    const int requests = 5000;
+    int sent = 0;
+    int received = 0;
+    uint32_t requestId;
+    IpcHeader header;
+    std::vector<uint8_t> response;
+    while (received < requests) {
+        while (sent < requests) {
+            std::vector<uint8_t> payload;
+            IpcWriter writer(payload);
+            writer.str("item");
+            writer.i32(sent + 1);
+            if (!client->post(IpcOp::PlacePreorder, payload, requestId)) {
+                break;
+            }
+            ++sent;
+        }
+        if (client->poll(header, response, 1000)) {
+            EXPECT_EQ(static_cast<uint16_t>(IpcStatus::Ok), header.status);
+            ++received;
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(requests), service.getPreorders().size());
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include "logging/logger.h"
+#include "metrics/metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class LoggerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        sink = std::tmpfile();
+        ASSERT_NE(nullptr, sink);
+        Logger::instance().setSink(sink);
+        Logger::instance().setLevel(LogLevel::Trace);
+    }
+
+    void TearDown() override {
+        Logger::instance().setSink(nullptr);
+        std::fclose(sink);
+    }
+
+    std::string readSink() {
+        Logger::instance().flush();
+        std::string contents;
+        std::rewind(sink);
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), sink)) > 0) {
+            contents.append(buffer, n);
+        }
+        return contents;
+    }
+
+    std::FILE* sink = nullptr;
+};
+
+TEST_F(LoggerTest, FormatsArgumentsOnWriterThread) {
+    std::string name = "Water Bottles";
+    HUB_LOG_INFO("Listing {} qty={} price={} active={}", name, 100, 1.5, true);
+
+    std::string output = readSink();
+    EXPECT_NE(std::string::npos, output.find("[INFO] Listing Water Bottles qty=100 price=1.5 active=true"))
+        << output;
+}
+
+TEST_F(LoggerTest, LongTextIsTruncated) {
+    std::string payload(1024 * 1024, 'A');
+    HUB_LOG_WARN("payload {}", payload);
+
+    std::string output = readSink();
+    EXPECT_NE(std::string::npos, output.find("[truncated]"));
+    EXPECT_LT(output.size(), 512u);
+}
+
+TEST_F(LoggerTest, CompiledOutStatementsDoNotEvaluateArguments) {
+#if HUB_LOG_LEVEL > 0
+    int evaluations = 0;
+    auto sideEffect = [&evaluations] { return ++evaluations; };
+    HUB_LOG_TRACE("never {}", sideEffect());
+    EXPECT_EQ(0, evaluations);
+#endif
+}
+
+TEST_F(LoggerTest, RuntimeLevelFiltersRecords) {
+    Logger::instance().setLevel(LogLevel::Error);
+    HUB_LOG_WARN("filtered warning");
+    HUB_LOG_ERROR("kept error");
+
+    std::string output = readSink();
+    EXPECT_EQ(std::string::npos, output.find("filtered warning"));
+    EXPECT_NE(std::string::npos, output.find("kept error"));
+}
+
+TEST_F(LoggerTest, ManyThreadsNeverBlock) {
+    const int threads = 4;
+    const int perThread = 20000;
+    uint64_t droppedBefore = Logger::instance().droppedCount();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < perThread; ++i) {
+                HUB_LOG_INFO("thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::string output = readSink();
+    size_t lines = 0;
+    for (char c : output) {
+        lines += c == '\n';
+    }
+    uint64_t dropped = Logger::instance().droppedCount() - droppedBefore;
+    EXPECT_EQ(static_cast<uint64_t>(threads * perThread), lines + dropped);
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << "Logged " << threads * perThread << " records (" << dropped << " dropped) at "
+              << ns / (threads * perThread) << " ns per call" << std::endl;
+}
+
+TEST_F(LoggerTest, WriterPublishesRingGauges) {
+    Gauge& occupancy = MetricsRegistry::instance().gauge("log_ring_occupancy");
+    Gauge& rings = MetricsRegistry::instance().gauge("log_rings");
+    HUB_LOG_INFO("gauge sample {}", 1);
+    readSink();
+    EXPECT_GE(rings.value(), 1);
+    EXPECT_GE(occupancy.value(), 0);
+    EXPECT_LE(occupancy.value(), static_cast<int64_t>(LogRing::kCapacity) * rings.value());
+}
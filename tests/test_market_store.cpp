@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include "business/hub_service.h"
+#include "storage/cow_vector.h"
+#include "storage/market_store.h"
+#include "storage/write_ahead_log.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <thread>
+#include <vector>
+
+class MarketStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        char pattern[] = "/tmp/hub-store-test-XXXXXX";
+        ASSERT_NE(nullptr, ::mkdtemp(pattern));
+        directory = pattern;
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(directory);
+    }
+
+    std::string directory;
+};
+
+TEST_F(MarketStoreTest, CowImageIsFrozen) {
+    CowVector<Preorder, 4> preorders;
+    for (int i = 0; i < 10; ++i) {
+        preorders.push_back({"item-" + std::to_string(i % 3), i});
+    }
+    auto position = preorders.push_back({"last", 10});
+    auto image = preorders.image();
+
+    preorders.mutableAt(position).quantity = 99;
+    preorders.removeIf([](const Preorder& p) { return p.itemName == "item-0"; });
+    preorders.push_back({"after", 11});
+
+    EXPECT_EQ(11u, image.size());
+    std::vector<int> quantities;
+    image.forEach([&](const Preorder& p) { quantities.push_back(p.quantity); });
+    ASSERT_EQ(11u, quantities.size());
+    EXPECT_EQ(0, quantities[0]);
+    EXPECT_EQ(10, quantities[10]);
+    EXPECT_EQ(8u, preorders.size());
+}
+
+TEST_F(MarketStoreTest, ConcurrentAppendsAreGroupCommitted) {
+    auto log = WriteAheadLog::open(directory, 0, [](uint64_t, const uint8_t*, size_t) {});
+    ASSERT_NE(nullptr, log);
+
+    const int threads = 8;
+    const int perThread = 500;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&log, t] {
+            for (int i = 0; i < perThread; ++i) {
+                std::string payload = std::to_string(t) + ":" + std::to_string(i);
+                uint64_t lsn = log->append(reinterpret_cast<const uint8_t*>(payload.data()), payload.size());
+                EXPECT_TRUE(log->waitDurable(lsn));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(static_cast<uint64_t>(threads * perThread), log->durableLsn());
+    log.reset();
+
+    uint64_t previous = 0;
+    int replayed = 0;
+    log = WriteAheadLog::open(directory, 0, [&](uint64_t lsn, const uint8_t*, size_t) {
+        EXPECT_EQ(previous + 1, lsn);
+        previous = lsn;
+        ++replayed;
+    });
+    ASSERT_NE(nullptr, log);
+    EXPECT_EQ(threads * perThread, replayed);
+}
+
+TEST_F(MarketStoreTest, TornTailIsTruncated) {
+    auto log = WriteAheadLog::open(directory, 0, [](uint64_t, const uint8_t*, size_t) {});
+    ASSERT_NE(nullptr, log);
+    for (int i = 0; i < 10; ++i) {
+        log->append(reinterpret_cast<const uint8_t*>("record"), 6);
+    }
+    ASSERT_TRUE(log->waitDurable(10));
+    log.reset();
+
+    std::FILE* segment = std::fopen((directory + "/wal-0000000000000001").c_str(), "ab");
+    ASSERT_NE(nullptr, segment);
+    std::fwrite("\x12\x34\x56\x78\x09\x00", 1, 6, segment);
+    std::fclose(segment);
+
+    int replayed = 0;
+    log = WriteAheadLog::open(directory, 0, [&](uint64_t, const uint8_t*, size_t) { ++replayed; });
+    ASSERT_NE(nullptr, log);
+    EXPECT_EQ(10, replayed);
+    EXPECT_EQ(11u, log->append(reinterpret_cast<const uint8_t*>("next"), 4));
+    ASSERT_TRUE(log->waitDurable(11));
+    log.reset();
+
+    replayed = 0;
+    log = WriteAheadLog::open(directory, 0, [&](uint64_t, const uint8_t*, size_t) { ++replayed; });
+    EXPECT_EQ(11, replayed);
+}
+
+TEST_F(MarketStoreTest, HubServiceRecoversAfterRestart) {
+    {
+        HubService service;
+        ASSERT_TRUE(service.enableDurability(directory));
+        ASSERT_TRUE(service.createListing({"Water Bottles", 100, 1.5}));
+        ASSERT_TRUE(service.createListing({"Blankets", 20, 12.0}));
+        ASSERT_TRUE(service.placePreorder({"Water Bottles", 2}));
+        ASSERT_TRUE(service.checkpoint());
+        ASSERT_TRUE(service.updateListing("Blankets", 15, 11.0));
+        ASSERT_TRUE(service.placePreorder({"Blankets", 1}));
+        ASSERT_TRUE(service.cancelPreorder("Water Bottles"));
+        EXPECT_FALSE(service.updateListing("Tents", 1, 1.0));
+    }
+
+    HubService restarted;
+    ASSERT_TRUE(restarted.enableDurability(directory));
+    auto listings = restarted.getListings();
+    ASSERT_EQ(2u, listings.size());
+    EXPECT_EQ("Blankets", listings[1].name);
+    EXPECT_EQ(15, listings[1].quantity);
+    EXPECT_DOUBLE_EQ(11.0, listings[1].price);
+    auto preorders = restarted.getPreorders();
+    ASSERT_EQ(1u, preorders.size());
+    EXPECT_EQ("Blankets", preorders[0].itemName);
+}
+
+TEST_F(MarketStoreTest, FailedWriteLatchesTheLog) {
+    {
+        HubService service;
+        ASSERT_TRUE(service.enableDurability(directory));
+        ASSERT_TRUE(service.createListing({"Water Bottles", 100, 1.5}));
+
+        // Cap the file size just past the segment so the next batch is torn.
+        struct stat info {};
+        ASSERT_EQ(0, ::stat((directory + "/wal/wal-0000000000000001").c_str(), &info));
+        rlimit saved {};
+        ::getrlimit(RLIMIT_FSIZE, &saved);
+        auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit capped = saved;
+        capped.rlim_cur = static_cast<rlim_t>(info.st_size) + 64;
+        ASSERT_EQ(0, ::setrlimit(RLIMIT_FSIZE, &capped));
+
+        EXPECT_FALSE(service.createListing({std::string(4096, 'x'), 1, 1.0}));
+        ::setrlimit(RLIMIT_FSIZE, &saved);
+        std::signal(SIGXFSZ, previousHandler);
+
+        // Latched: later writes are refused without being applied, even
+        // though the disk would take them now, and nothing is snapshotted.
+        EXPECT_FALSE(service.createListing({"Blankets", 20, 12.0}));
+        EXPECT_FALSE(service.updateListing("Water Bottles", 1, 1.0));
+        EXPECT_FALSE(service.checkpoint());
+        Listing listing;
+        EXPECT_FALSE(service.findListing("Blankets", listing));
+        ASSERT_TRUE(service.findListing("Water Bottles", listing));
+        EXPECT_EQ(100, listing.quantity);
+    }
+
+    HubService restarted;
+    ASSERT_TRUE(restarted.enableDurability(directory));
+    auto listings = restarted.getListings();
+    ASSERT_EQ(1u, listings.size());
+    EXPECT_EQ("Water Bottles", listings[0].name);
+}
+
+TEST_F(MarketStoreTest, DurableWriteThroughput) {
+    HubService service;
+    ASSERT_TRUE(service.enableDurability(directory));
+
+    const int threads = 16;
+    const int perThread = 250;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t) {
+        writers.emplace_back([&service, t] {
+            for (int i = 0; i < perThread; ++i) {
+                EXPECT_TRUE(service.placePreorder({"item-" + std::to_string(t), i + 1}));
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    EXPECT_EQ(static_cast<size_t>(threads * perThread), service.getPreorders().size());
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    std::cout << threads * perThread << " durable writes from " << threads << " threads in " << us
+              << " microseconds (" << (threads * perThread * 1e6 / us) << " writes/s)" << std::endl;
+}
+
+TEST_F(MarketStoreTest, MillionRecordRestart) {
+    const int listings = 600000;
+    const int preorders = 400000;
+    {
+        BusinessInterface business;
+        RecipientInterface recipient;
+        auto store = MarketStore::open(directory, business, recipient);
+        ASSERT_NE(nullptr, store);
+        for (int i = 0; i < listings; ++i) {
+            Listing listing{"listing-" + std::to_string(i), i, 1.0};
+            business.createListing(listing);
+            store->logCreateListing(listing);
+        }
+        for (int i = 0; i < preorders; ++i) {
+            Preorder preorder{"listing-" + std::to_string(i), 1};
+            recipient.placePreorder(preorder);
+            store->logPlacePreorder(preorder);
+        }
+        MarketStore::Image image{store->lastLsn(), business.image(), recipient.image()};
+        store->beginSnapshot();
+        ASSERT_TRUE(store->writeSnapshot(image));
+
+        // Tail that only exists in the log.
+        for (int i = 0; i < 10000; ++i) {
+            business.updateListing("listing-" + std::to_string(i), 0, 2.0);
+            store->logUpdateListing("listing-" + std::to_string(i), 0, 2.0);
+        }
+        ASSERT_TRUE(store->waitDurable(store->lastLsn()));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    HubService service;
+    ASSERT_TRUE(service.enableDurability(directory));
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+    std::cout << "Recovered " << listings + preorders << " records in " << elapsed.count() << " ms" << std::endl;
+
+    auto recovered = service.getListings();
+    ASSERT_EQ(static_cast<size_t>(listings), recovered.size());
+    EXPECT_EQ(0, recovered[9999].quantity);
+    EXPECT_EQ(10000, recovered[10000].quantity);
+    EXPECT_EQ(static_cast<size_t>(preorders), service.getPreorders().size());
+#ifdef NDEBUG
+    EXPECT_LT(elapsed.count(), 1000);
+#endif
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include "metrics/metrics.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (uint64_t ns = 1; ns <= 100000; ++ns) {
+        histogram.record(ns);
+    }
+    EXPECT_EQ(100000u, histogram.count());
+    EXPECT_EQ(100000u, histogram.max());
+
+    // Sub-bucket resolution of 1/16 bounds the relative error to ~6.25%.
+    for (double q : {0.5, 0.9, 0.99}) {
+        double expected = q * 100000;
+        double actual = static_cast<double>(histogram.percentile(q));
+        EXPECT_NEAR(expected, actual, expected * 0.0625) << "q=" << q;
+    }
+}
+
+TEST(LatencyHistogramTest, BucketBoundsAreContiguous) {
+    for (int bucket = 1; bucket < LatencyHistogram::kBuckets; ++bucket) {
+        uint64_t lower = LatencyHistogram::bucketUpperBound(bucket - 1) + 1;
+        EXPECT_EQ(bucket, LatencyHistogram::bucketFor(lower)) << "bucket " << bucket;
+        EXPECT_EQ(bucket, LatencyHistogram::bucketFor(LatencyHistogram::bucketUpperBound(bucket)));
+    }
+}
+
+TEST(MetricsRegistryTest, ConcurrentCountersAreExact) {
+    Counter& counter = MetricsRegistry::instance().counter("test_concurrent_events");
+    const int threads = 4;
+    const int perThread = 100000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&counter] {
+            for (int i = 0; i < perThread; ++i) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(static_cast<uint64_t>(threads * perThread), counter.value());
+    EXPECT_EQ(&counter, &MetricsRegistry::instance().counter("test_concurrent_events"));
+}
+
+TEST(MetricsRegistryTest, RenderTextIncludesAllKinds) {
+    MetricsRegistry& registry = MetricsRegistry::instance();
+    registry.counter("test_render_counter").add(3);
+    registry.gauge("test_render_queue_depth").set(7);
+    {
+        TraceSpan span("test_render_span", registry.histogram("test_render_ns"));
+    }
+
+    std::string text = registry.renderText();
+    EXPECT_NE(std::string::npos, text.find("test_render_counter 3\n"));
+    EXPECT_NE(std::string::npos, text.find("test_render_queue_depth 7\n"));
+    EXPECT_NE(std::string::npos, text.find("test_render_ns{quantile=\"0.99\"}"));
+    EXPECT_NE(std::string::npos, text.find("test_render_ns_count 1\n"));
+}
+
+TEST(MetricsExporterTest, WritesSnapshotFile) {
+    std::string path = ::testing::TempDir() + "hub_metrics_test.prom";
+    MetricsRegistry::instance().counter("test_exported_counter").add(42);
+    {
+        MetricsExporter exporter(path, std::chrono::milliseconds(10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+
+    std::ifstream file(path);
+    ASSERT_TRUE(file.good());
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_NE(std::string::npos, contents.str().find("test_exported_counter 42"));
+    std::remove(path.c_str());
+}
+
+TEST(MetricsOverheadTest, SpanCostIsNanoseconds) {
+    LatencyHistogram& histogram = MetricsRegistry::instance().histogram("test_overhead_ns");
+    const int iterations = 1000000;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        TraceSpan span("test_overhead", histogram);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    std::cout << "TraceSpan overhead: " << ns / iterations << " ns per span" << std::endl;
+    EXPECT_EQ(static_cast<uint64_t>(iterations), histogram.count());
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "devices/local_communication.h"
+#include "riif_ultrasonic.h"
+#include "ultrasonic/acoustic_channel.h"
+#include "ultrasonic/ultrasonic_modem.h"
+#include <string>
+#include <vector>
+
+// The preorder_feature tests need PortAudio and a phone playing the PWA's
+// signal. These run the same exchange headless, with AcousticChannel
+// standing in for the air between the hub's speaker and the phone.
+
+namespace {
+
+const std::string kPreorder = R"(TEST:{"itemName":"Water Bottles","quantity":2})";
+
+// A phone across a tent from the hub: 20 dB down, one wall bounce, a cheap
+// clock and a noisy room.
+AcousticChannel::Config tentChannel() {
+    AcousticChannel::Config config;
+    config.attenuationDb = 20;
+    config.echoes = {{0.004, 0.3}};
+    config.clockDriftPpm = 20;
+    config.snrDb = 10;
+    return config;
+}
+
+UltrasonicModem receiverModem() {
+    RiifUltrasonic::Parameters params;
+    return UltrasonicModem(params.sampleRate, params.f0, params.df, params.samplesPerFrame);
+}
+
+}  // namespace
+
+TEST(PreorderLoopbackTest, AnnouncedPreorderSurvivesTheAir) {
+    LocalCommunication hub;
+    ASSERT_TRUE(hub.initializeUltrasonic());
+    ASSERT_TRUE(hub.broadcastAnnouncement(kPreorder));
+
+    std::vector<int16_t> recorded = AcousticChannel(tentChannel(), 7).transmit(hub.lastTransmission());
+    std::string received = receiverModem().decode(recorded);
+    ASSERT_EQ(0u, received.find("TEST:"));
+    EXPECT_EQ(kPreorder, received);
+}
+
+TEST(PreorderLoopbackTest, EncryptedPreorderSurvivesTheAir) {
+    LocalCommunication hub;
+    ASSERT_TRUE(hub.initializeUltrasonic());
+    ASSERT_TRUE(hub.performKeyExchange());
+    ASSERT_TRUE(hub.sendSecureData(kPreorder));
+
+    // The ciphertext has to arrive bit for bit; one flipped bit garbles the
+    // byte it lands in.
+    UltrasonicModem modem = receiverModem();
+    std::vector<int16_t> recorded = AcousticChannel(tentChannel(), 7).transmit(hub.lastTransmission());
+    EXPECT_EQ(modem.decode(hub.lastTransmission()), modem.decode(recorded));
+
+    std::string order;
+    ASSERT_TRUE(hub.receiveSecureData(order));
+    EXPECT_EQ(kPreorder, order);
+}
+
+TEST(PreorderLoopbackTest, DrownedPreorderIsNotDecoded) {
+    LocalCommunication hub;
+    ASSERT_TRUE(hub.initializeUltrasonic());
+    ASSERT_TRUE(hub.broadcastAnnouncement(kPreorder));
+
+    AcousticChannel::Config config = tentChannel();
+    config.snrDb = -20;
+    std::vector<int16_t> recorded = AcousticChannel(config, 7).transmit(hub.lastTransmission());
+    EXPECT_NE(kPreorder, receiverModem().decode(recorded));
+}
@@ -6,6 +6,9 @@
 #include <chrono>
 #include <iostream>
 #include <atomic>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 class SatelliteHubTest : public ::testing::Test {
 protected:
@@ -87,3 +90,50 @@ TEST_F(SatelliteHubTest, ConcurrentSendReceive) {
         EXPECT_EQ(sentMessages[i], receivedMessages[i]) << "Mismatch at index " << i;
     }
 }
+
+TEST_F(SatelliteHubTest, SendPathInstrumentationOverhead) {
+    // The same link work as SatelliteHub::sendData without its metrics and
+    // logging, on a session of its own.
+    SRPT::Satellite::SatelliteConfig config;
+    config.setProvider(SRPT::Satellite::Provider::STARLINK);
+    auto session = SRPT::Satellite::CreateSatelliteSession(config);
+    ASSERT_TRUE(session && session->Connect("starlink-1"));
+    auto bareSend = [&session](const std::string& data) {
+        auto stream = session->CreateSatelliteStream();
+        SRPT::ByteVector byteData(data.begin(), data.end());
+        return stream && stream->Write(byteData);
+    };
+
+    const std::string payload(4096, 'P');
+    const int sends = 2000;
+    auto timeSend = [&payload](auto&& send) {
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_TRUE(send(payload));
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto instrumentedSend = [this](const std::string& data) { return hub.sendData(data); };
+
+    // Sends alternate, and which side goes first alternates too, so cache
+    // and allocator state don't favour either path. Timer cost hits both.
+    std::vector<double> bare, instrumented;
+    for (int i = 0; i < sends; ++i) {
+        if (i % 2) {
+            bare.push_back(timeSend(bareSend));
+            instrumented.push_back(timeSend(instrumentedSend));
+        } else {
+            instrumented.push_back(timeSend(instrumentedSend));
+            bare.push_back(timeSend(bareSend));
+        }
+    }
+    std::sort(bare.begin(), bare.end());
+    std::sort(instrumented.begin(), instrumented.end());
+    double bareNs = bare[sends / 2];
+    double instrumentedNs = instrumented[sends / 2];
+    std::cout << "Satellite send (median): " << bareNs << " ns bare, " << instrumentedNs << " ns instrumented ("
+              << 100.0 * (instrumentedNs - bareNs) / bareNs << "% overhead)" << std::endl;
+    // Budget is 1% of the send. The allowance covers the span's two clock
+    // reads and timer jitter on the median; it doesn't grow with the send,
+    // so against a real link it is negligible.
+    constexpr double kNoiseAllowanceNs = 250;
+    EXPECT_LE(instrumentedNs, bareNs * 1.01 + kNoiseAllowanceNs);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include "core/timer_wheel.h"
+#include "devices/local_communication.h"
+#include "metrics/metrics.h"
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FiredTimer {
+    TimerWheel* wheel = nullptr;
+    uint64_t firedAt = 0;
+    int fireCount = 0;
+};
+
+void recordFire(void* context) {
+    auto* fired = static_cast<FiredTimer*>(context);
+    fired->firedAt = fired->wheel->now();
+    ++fired->fireCount;
+}
+
+}  // namespace
+
+class TimerWheelTest : public ::testing::Test {
+protected:
+    TimerWheel wheel;
+};
+
+TEST_F(TimerWheelTest, FiresAtExactTick) {
+    FiredTimer fired{&wheel};
+    TimerWheel::Timer timer(&recordFire, &fired);
+    wheel.schedule(timer, 10);
+    EXPECT_TRUE(timer.isPending());
+
+    EXPECT_EQ(0u, wheel.advance(9));
+    EXPECT_EQ(0, fired.fireCount);
+    EXPECT_EQ(1u, wheel.advance(1));
+    EXPECT_EQ(1, fired.fireCount);
+    EXPECT_EQ(10u, fired.firedAt);
+    EXPECT_FALSE(timer.isPending());
+    EXPECT_EQ(0u, wheel.pending());
+}
+
+TEST_F(TimerWheelTest, CancelPreventsFiring) {
+    FiredTimer fired{&wheel};
+    TimerWheel::Timer timer(&recordFire, &fired);
+    wheel.schedule(timer, 5);
+    wheel.cancel(timer);
+    EXPECT_EQ(0u, wheel.pending());
+    wheel.advance(100);
+    EXPECT_EQ(0, fired.fireCount);
+}
+
+TEST_F(TimerWheelTest, LongDelaysCascadeToExactTick) {
+    const uint64_t delays[] = {255, 256, 257, 16383, 16384, 1000003, (uint64_t(1) << 26) + 17,
+                               (uint64_t(1) << 32) + 5};
+    std::vector<std::unique_ptr<FiredTimer>> fired;
+    std::vector<std::unique_ptr<TimerWheel::Timer>> timers;
+    for (uint64_t delay : delays) {
+        fired.push_back(std::make_unique<FiredTimer>(FiredTimer{&wheel}));
+        timers.push_back(std::make_unique<TimerWheel::Timer>(&recordFire, fired.back().get()));
+        wheel.schedule(*timers.back(), delay);
+    }
+
+    wheel.advance((uint64_t(1) << 32) + 10);
+    for (size_t i = 0; i < fired.size(); ++i) {
+        EXPECT_EQ(1, fired[i]->fireCount) << "delay " << delays[i];
+        EXPECT_EQ(delays[i], fired[i]->firedAt) << "delay " << delays[i];
+    }
+}
+
+TEST_F(TimerWheelTest, CallbackCanRescheduleItself) {
+    struct Periodic {
+        TimerWheel* wheel = nullptr;
+        TimerWheel::Timer timer;
+        int fireCount = 0;
+    } periodic;
+    periodic.wheel = &wheel;
+    periodic.timer.setCallback([](void* context) {
+        auto* self = static_cast<Periodic*>(context);
+        ++self->fireCount;
+        self->wheel->schedule(self->timer, 100);
+    }, &periodic);
+
+    wheel.schedule(periodic.timer, 100);
+    wheel.advance(1000);
+    EXPECT_EQ(10, periodic.fireCount);
+    EXPECT_TRUE(periodic.timer.isPending());
+}
+
+TEST_F(TimerWheelTest, DestroyedTimerUnlinksItself) {
+    FiredTimer fired{&wheel};
+    {
+        TimerWheel::Timer timer(&recordFire, &fired);
+        wheel.schedule(timer, 50);
+        EXPECT_EQ(1u, wheel.pending());
+    }
+    EXPECT_EQ(0u, wheel.pending());
+    wheel.advance(100);
+    EXPECT_EQ(0, fired.fireCount);
+}
+
+TEST_F(TimerWheelTest, MillionPendingTimers) {
+    const size_t count = 1000000;
+    std::vector<TimerWheel::Timer> timers(count);
+    uint64_t fireCount = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        timers[i].setCallback([](void* context) { ++*static_cast<uint64_t*>(context); }, &fireCount);
+        wheel.schedule(timers[i], 1 + (i * 7919) % 60000);
+    }
+    auto scheduled = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < count; i += 2) {
+        wheel.cancel(timers[i]);
+    }
+    auto cancelled = std::chrono::high_resolution_clock::now();
+    wheel.advance(60000);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    EXPECT_EQ(count / 2, fireCount);
+    EXPECT_EQ(0u, wheel.pending());
+
+    auto us = [](auto d) { return std::chrono::duration_cast<std::chrono::microseconds>(d).count(); };
+    std::cout << "Schedule " << count << " timers: " << us(scheduled - start) << " microseconds" << std::endl;
+    std::cout << "Cancel " << count / 2 << " timers: " << us(cancelled - scheduled) << " microseconds" << std::endl;
+    std::cout << "Expire " << fireCount << " timers: " << us(end - cancelled) << " microseconds" << std::endl;
+}
+
+TEST_F(TimerWheelTest, DrivesKeyRotationAndSessionExpiry) {
+    Counter& exchanges = MetricsRegistry::instance().counter("ultrasonic_key_exchanges");
+    LocalCommunication comm;
+    ASSERT_TRUE(comm.initializeUltrasonic());
+    ASSERT_TRUE(comm.performKeyExchange());
+    comm.enableKeyLifecycle(wheel, 100, 250);
+    EXPECT_EQ(2u, wheel.pending());
+
+    ASSERT_TRUE(comm.sendSecureData("ping"));
+    std::vector<int16_t> before = comm.lastTransmission();
+    uint64_t exchangesBefore = exchanges.value();
+
+    // Rotation swaps the key; both ends still agree on it.
+    wheel.advance(100);
+    EXPECT_EQ(exchangesBefore + 1, exchanges.value());
+    ASSERT_TRUE(comm.hasSessionKey());
+    ASSERT_TRUE(comm.sendSecureData("ping"));
+    EXPECT_NE(before, comm.lastTransmission());
+    std::string received;
+    ASSERT_TRUE(comm.receiveSecureData(received));
+    EXPECT_EQ("ping", received);
+
+    // Traffic at tick 100 pushes expiry to 350; rotations alone don't.
+    wheel.advance(249);
+    EXPECT_TRUE(comm.hasSessionKey());
+    EXPECT_EQ(exchangesBefore + 3, exchanges.value());
+    wheel.advance(1);
+    EXPECT_FALSE(comm.hasSessionKey());
+    EXPECT_EQ(0u, wheel.pending());
+
+    // Nothing fires once the session is gone; a new exchange re-arms both.
+    wheel.advance(1000);
+    EXPECT_EQ(exchangesBefore + 3, exchanges.value());
+    ASSERT_TRUE(comm.performKeyExchange());
+    EXPECT_EQ(2u, wheel.pending());
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include "devices/local_communication.h"
+#include "ultrasonic/ultrasonic_modem.h"
+#include "ultrasonic/waveform_synthesizer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string randomPayload(size_t length, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::string payload(length, '\0');
+    for (auto& c : payload) {
+        c = static_cast<char>(random() & 0xFF);
+    }
+    return payload;
+}
+
+// Continuous-phase FSK straight from std::sin, one call per sample.
+std::vector<int16_t> referenceCpfsk(const std::string& data, int sampleRate, double f0, double df, int frame) {
+    std::vector<int16_t> pcm;
+    double phase = 0;
+    for (unsigned char c : data) {
+        for (int bit = 0; bit < 8; ++bit) {
+            double step = 2 * M_PI * ((c >> bit) & 1 ? f0 + df : f0) / sampleRate;
+            for (int i = 0; i < frame; ++i) {
+                pcm.push_back(static_cast<int16_t>(32767 * std::sin(phase)));
+                phase = std::fmod(phase + step, 2 * M_PI);
+            }
+        }
+    }
+    return pcm;
+}
+
+int maxDeviation(const std::vector<int16_t>& a, const std::vector<int16_t>& b) {
+    int worst = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        worst = std::max(worst, std::abs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+}  // namespace
+
+TEST(WaveformSynthesizerTest, WholeCycleFramesNeedTwoTables) {
+    std::string payload = randomPayload(128, 1);
+    WaveformSynthesizer synthesizer(48000, 15000.0, 1000.0, 480);
+    std::vector<int16_t> pcm = synthesizer.synthesize(payload);
+
+    EXPECT_EQ(2u, synthesizer.stats().symbolTables);
+    EXPECT_LE(maxDeviation(referenceCpfsk(payload, 48000, 15000.0, 1000.0, 480), pcm), 40);
+    EXPECT_EQ(payload, UltrasonicModem(48000, 15000.0, 1000.0, 480).decode(pcm));
+
+    WaveformSynthesizer::Config aligned;
+    aligned.continuousPhase = false;
+    EXPECT_EQ(pcm, WaveformSynthesizer(48000, 15000.0, 1000.0, 480, aligned).synthesize(payload));
+}
+
+TEST(WaveformSynthesizerTest, CarriesPhaseAcrossPartialCycleFrames) {
+    std::string payload = randomPayload(128, 2);
+    WaveformSynthesizer synthesizer(48000, 15000.0, 1000.0, 441);
+    std::vector<int16_t> pcm = synthesizer.synthesize(payload);
+
+    EXPECT_LE(maxDeviation(referenceCpfsk(payload, 48000, 15000.0, 1000.0, 441), pcm), 40);
+    EXPECT_GT(synthesizer.stats().symbolTables, 2u);
+    EXPECT_LE(synthesizer.stats().symbolTables, 64u);
+    EXPECT_EQ(payload, UltrasonicModem(48000, 15000.0, 1000.0, 441).decode(pcm));
+}
+
+TEST(WaveformSynthesizerTest, FallsBackToOscillatorPastTableLimit) {
+    std::string payload = randomPayload(128, 3);
+    WaveformSynthesizer::Config config;
+    config.maxSymbolTables = 4;
+    WaveformSynthesizer synthesizer(44100, 17000.5, 1500.25, 441, config);
+    std::vector<int16_t> pcm = synthesizer.synthesize(payload);
+
+    EXPECT_EQ(4u, synthesizer.stats().symbolTables);
+    EXPECT_LE(maxDeviation(referenceCpfsk(payload, 44100, 17000.5, 1500.25, 441), pcm), 40);
+    EXPECT_EQ(payload, UltrasonicModem(44100, 17000.5, 1500.25, 441).decode(pcm));
+}
+
+TEST(WaveformSynthesizerTest, CachesRepeatedPayloadsWithinBudget) {
+    WaveformSynthesizer::Config config;
+    config.cacheBytes = 3 * 8 * 480 * sizeof(int16_t) * 16;  // three 16-byte payloads
+    WaveformSynthesizer synthesizer(48000, 15000.0, 1000.0, 480, config);
+    std::string beacon = "HUB-7 OPEN 0800!";
+
+    auto first = synthesizer.cached(beacon);
+    auto second = synthesizer.cached(beacon);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(synthesizer.synthesize(beacon), *first);
+    EXPECT_EQ(1u, synthesizer.stats().cacheHits);
+    EXPECT_EQ(1u, synthesizer.stats().cacheMisses);
+
+    for (int i = 0; i < 3; ++i) {
+        synthesizer.cached(randomPayload(16, 10 + i));
+    }
+    EXPECT_EQ(1u, synthesizer.stats().cacheEvictions);
+    EXPECT_LE(synthesizer.stats().cachedBytes, config.cacheBytes);
+    EXPECT_NE(first, synthesizer.cached(beacon));  // evicted, synthesized again
+    EXPECT_EQ(synthesizer.synthesize(beacon), *first);  // still valid for its holder
+}
+
+TEST(WaveformSynthesizerTest, LocalCommunicationSendPath) {
+    LocalCommunication local;
+    ASSERT_TRUE(local.initializeUltrasonic());
+    ASSERT_TRUE(local.performKeyExchange());
+    ASSERT_TRUE(local.sendSecureData("ten boxes of water at bay 4"));
+    std::string received;
+    ASSERT_TRUE(local.receiveSecureData(received));
+    EXPECT_EQ("ten boxes of water at bay 4", received);
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(local.broadcastAnnouncement("hub beacon"));
+    }
+    EXPECT_EQ(4u, local.synthesizer().stats().cacheHits);
+    EXPECT_EQ(size_t(10 * 8) * local.synthesizer().samplesPerFrame(), local.lastTransmission().size());
+}
+
+TEST(WaveformSynthesizerTest, Benchmark) {
+    std::string payload = randomPayload(64 * 1024, 4);
+    WaveformSynthesizer wholeCycles(48000, 15000.0, 1000.0, 480);
+    WaveformSynthesizer partialCycles(48000, 15000.0, 1000.0, 441);
+    volatile size_t sink = 0;
+
+    auto time = [&](auto func) {
+        auto start = std::chrono::steady_clock::now();
+        func();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    // The per-sample reference runs on a 4 KiB slice to keep the test short.
+    std::string slice = payload.substr(0, 4096);
+    double referenceSeconds = time([&] { sink += referenceCpfsk(slice, 48000, 15000.0, 1000.0, 480).size(); });
+    double wholeSeconds = time([&] { sink += wholeCycles.synthesize(payload).size(); });
+    double partialSeconds = time([&] { sink += partialCycles.synthesize(payload).size(); });
+    double cachedSeconds = time([&] {
+        for (int i = 0; i < 100; ++i) {
+            sink += wholeCycles.cached("hub beacon")->size();
+        }
+    });
+
+    double audioSeconds = static_cast<double>(payload.size()) * 8 * 480 / 48000;
+    double referenceRealTime = audioSeconds / 16 / referenceSeconds;
+    std::cout << "64 KiB payload, " << audioSeconds << " s of audio" << std::endl;
+    std::cout << "std::sin per sample   " << referenceSeconds * 1e3 << " ms (4 KiB)  " << referenceRealTime
+              << "x real time" << std::endl;
+    std::cout << "tables, whole cycles  " << wholeSeconds * 1e3 << " ms  " << audioSeconds / wholeSeconds
+              << "x real time" << std::endl;
+    std::cout << "tables, partial       " << partialSeconds * 1e3 << " ms  "
+              << audioSeconds * 441 / 480 / partialSeconds << "x real time" << std::endl;
+    std::cout << "cached beacon         " << cachedSeconds * 1e6 / 100 << " us per send" << std::endl;
+
+    EXPECT_GT(audioSeconds / wholeSeconds, 1000.0);
+    EXPECT_GT(audioSeconds / wholeSeconds, referenceRealTime);
+}
@@ -0,0 +1,123 @@
+// Throughput/latency benchmark for the shared-memory IPC bridge.
+//
+//   hub_ipc_bench                     # embedded daemon thread, default sizes
+//   hub_ipc_bench --connect NAME      # against a running DisasterReliefSatelliteHub
+//   hub_ipc_bench --requests N --window W
+
+#include "business/hub_service.h"
+#include "ipc/hub_ipc.h"
+#include "metrics/metrics.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t elapsedNs(Clock::time_point start) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+std::vector<uint8_t> listingPayload(int i) {
+    std::vector<uint8_t> payload;
+    IpcWriter writer(payload);
+    writer.str("item-" + std::to_string(i));
+    writer.i32(100);
+    writer.f64(1.5);
+    return payload;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::string connectName;
+    int requests = 200000;
+    int window = 256;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--connect" && i + 1 < argc) {
+            connectName = argv[++i];
+        } else if (arg == "--requests" && i + 1 < argc) {
+            requests = std::atoi(argv[++i]);
+        } else if (arg == "--window" && i + 1 < argc) {
+            window = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--connect NAME] [--requests N] [--window W]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    HubService service;
+    std::atomic<bool> running{true};
+    std::unique_ptr<HubIpcServer> server;
+    std::thread serverThread;
+    std::string name = connectName;
+    if (name.empty()) {
+        name = "bench-" + std::to_string(::getpid());
+        auto channel = ShmChannel::create(name);
+        if (!channel) {
+            std::fprintf(stderr, "Cannot create channel %s\n", name.c_str());
+            return EXIT_FAILURE;
+        }
+        server = std::make_unique<HubIpcServer>(service, std::move(channel));
+        serverThread = std::thread([&] { server->serve(running); });
+    }
+
+    auto channel = ShmChannel::connect(name);
+    if (!channel) {
+        std::fprintf(stderr, "Cannot connect to channel %s\n", name.c_str());
+        return EXIT_FAILURE;
+    }
+    HubIpcClient client(std::move(channel));
+
+    // Round-trip latency: one outstanding request at a time.
+    LatencyHistogram latency;
+    std::vector<uint8_t> response;
+    int failures = 0;
+    for (int i = 0; i < requests / 10; ++i) {
+        auto start = Clock::now();
+        if (client.call(IpcOp::PlacePreorder, listingPayload(i), response) != IpcStatus::Ok) {
+            ++failures;
+        }
+        latency.record(elapsedNs(start));
+    }
+    std::printf("round trip (%d calls): p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n",
+                requests / 10, static_cast<unsigned long long>(latency.percentile(0.5)),
+                static_cast<unsigned long long>(latency.percentile(0.99)),
+                static_cast<unsigned long long>(latency.percentile(0.999)),
+                static_cast<unsigned long long>(latency.max()));
+
+    // Throughput: keep up to `window` requests in flight.
+    int sent = 0;
+    int received = 0;
+    uint32_t requestId;
+    IpcHeader header;
+    auto start = Clock::now();
+    while (received < requests) {
+        while (sent < requests && sent - received < window &&
+               client.post(IpcOp::CreateListing, listingPayload(sent), requestId)) {
+            ++sent;
+        }
+        if (client.poll(header, response, 1000)) {
+            failures += header.status != static_cast<uint16_t>(IpcStatus::Ok);
+            ++received;
+        }
+    }
+    double seconds = static_cast<double>(elapsedNs(start)) / 1e9;
+    std::printf("pipelined (window %d): %d requests in %.3f s = %.0f req/s\n", window, requests, seconds,
+                requests / seconds);
+    std::printf("failures: %d\n", failures);
+
+    if (serverThread.joinable()) {
+        running = false;
+        server->stop();
+        serverThread.join();
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}